@@ -6,6 +6,24 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version	
+2026-10-16: Interrupt driven channel scan with ADC noise reduction sleep
+2026-10-16: Free-running double buffered mode
+2026-10-16: Per-channel oversampling/EMA filter stage
+2026-10-16: Priority weighted scan list, sample age
+2026-10-16: Fast 8bit left adjusted scan mode
+2026-10-16: Skew compensated relay drop from paired BAT/ALT samples
+2026-10-16: Median of 3/5 spike filter
+2026-10-16: Per-channel gain/offset calibration from EEPROM
+2026-10-16: Idle sleep while Timer0 system tick runs
+2026-10-16: ADC prescaler follows CPU clock divider
+2026-10-16: Instant trip window check in conversion ISR
+2026-10-16: Free-running only when conversion is longer than worst case ISR
+2026-10-16: Relay drop of precise scans in calibrated counts
+2026-10-16: Relay drop paired before median, median on drop per resolution
+2026-10-16: Calibration on read, ISR works in raw counts
+2026-10-16: Instant trip confirmed by back-to-back re-conversion in ISR
+2026-10-16: Channel conversion synchronized to Timer1 overflow
+2026-10-16: Short driver description
 */
 
 /**** Hardware configuration ****
@@ -19,17 +37,106 @@ ADC=Vin*1024/Vref
 Fadc = Fcpu/DIV
 One conversion = 13.5 Fadc cycles
 ADC clock has to be between 50kHz and 200kHz for 10bit values
+Prescaler follows CPU clock: 10bit at 125kHz, fast 8bit (ADLAR, 80mV/LSB) at 500kHz
+*/
+
+/**** Description ****
+Conversion ISR walks the scan list, ADC_SCAN_FRAME conversions per scan, and
+stores raw samples with a conversion stamp for sample age. Default list:
+BAT, ALT, BAT, ALT | ISOL, BAT, ALT, IGNC
+10bit samples pass median and filter stages (Q10.6), relay drop is paired from
+adjacent BAT/ALT samples before median. Getters apply calibration on read.
+Sample outside of instant trip window is re-converted at once, confirmed one
+calls window handler. Synchronized channel is started by Timer1 overflow.
+Free-running is used only when conversion outlasts worst case ISR.
 */
 
 /**** Includes ****/
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/eeprom.h>
+#include <util/atomic.h>
 #include "adc_driver.h"
 
+/**** Private definitions ****/
+#define ADC_CH_COUNT	4
+#define ADC_MED_BUF		5
+#define ADC_ISR_CYCLES	600	//Worst case conversion ISR, CPU cycles
+#define ADC_CONV_CLK	13	//Free-running conversion, ADC clocks
+#define ADC_DROP_BIAS	0x800	//Drop median offset, half LSB drop is within +-0x7FE
+
+typedef struct AdcCalStruct {
+	uint16_t gain;
+	int8_t offset;
+}AdcCalDef;
+
 /**** Private variables ****/
-static volatile uint16_t bat_mon = 0;
-static volatile uint16_t isol_mon = 0;
-static volatile uint16_t ign_mon = 0;
-static volatile uint16_t alt_mon = 0;
+static volatile uint16_t adc_live[ADC_CH_COUNT];
+static volatile uint16_t adc_frame[ADC_CH_COUNT];
+static volatile uint8_t stamp_live[ADC_CH_COUNT];
+static volatile uint8_t stamp_frame[ADC_CH_COUNT];
+static volatile uint8_t conv_cnt = 0;
+static volatile uint8_t frame_stamp = 0;
+
+static volatile uint8_t fast_live[ADC_CH_COUNT];
+static volatile uint8_t fast_frame[ADC_CH_COUNT];
+
+static volatile uint8_t hist_ch[2] = {0xFF,0xFF};
+static volatile uint16_t hist_val[2];
+static volatile uint8_t drop_pos[2] = {0xFF,0xFF}; //Drop median per resolution
+static volatile uint16_t drop_med[2][ADC_MED_BUF];
+static volatile int16_t drop_live = 0;
+static volatile int16_t drop_frame = 0;
+
+static volatile uint8_t mode = ADC_MODE_SINGLE;
+static volatile uint8_t freerun_req = 0;
+static volatile uint8_t res = ADC_RES_10BIT;
+static volatile uint8_t scan_done = 1;
+static volatile uint8_t sync_ch = ADC_SYNC_NONE;
+static uint8_t adps_precise = 0x03;
+static uint8_t adps_fast = 0x01;
+
+static uint8_t scan_list[ADC_SCAN_LIST_MAX] = {ADC_BATU,ADC_ALTU,ADC_BATU,ADC_ALTU,ADC_ISOL,ADC_BATU,ADC_ALTU,ADC_IGNC};
+static uint8_t scan_len = 8;
+static uint8_t scan_frame = ADC_SCAN_FRAME;
+static volatile uint8_t conv_pos = 0;
+static volatile uint8_t mux_pos = 0;
+static volatile uint8_t frame_cnt = 0;
+
+static volatile uint8_t med_len[ADC_CH_COUNT];
+static volatile uint8_t med_pos[ADC_CH_COUNT];
+static volatile uint16_t med_buf[ADC_CH_COUNT][ADC_MED_BUF];
+
+static volatile uint8_t filt_mode[ADC_CH_COUNT];
+static volatile uint8_t filt_shift[ADC_CH_COUNT];
+static volatile uint8_t filt_cnt[ADC_CH_COUNT];
+static volatile uint16_t filt_acc[ADC_CH_COUNT];
+static volatile uint16_t filt_val[ADC_CH_COUNT];
+
+static volatile uint16_t win_low[ADC_CH_COUNT] = {ADC_WIN_LOW_OFF,ADC_WIN_LOW_OFF,ADC_WIN_LOW_OFF,ADC_WIN_LOW_OFF};
+static volatile uint16_t win_high[ADC_CH_COUNT] = {ADC_WIN_HIGH_OFF,ADC_WIN_HIGH_OFF,ADC_WIN_HIGH_OFF,ADC_WIN_HIGH_OFF};
+static volatile uint8_t win_retry = 0; //Re-conversion of outside sample running
+static void (* volatile pWinHandler)(uint8_t ch) = 0;
+
+static AdcCalDef cal[ADC_CH_COUNT];
+static uint16_t cal_inv[ADC_CH_COUNT]; //Inverse gain, Q1.15
+static AdcCalDef EEMEM ee_cal[ADC_CH_COUNT] = {{ADC_CAL_UNITY,0},{ADC_CAL_UNITY,0},{ADC_CAL_UNITY,0},{ADC_CAL_UNITY,0}};
+
+/**** Private function declarations ****/
+static void FilterSample(uint8_t ch, uint16_t raw);
+static void ApplyResolution(void);
+static void PairSample(uint8_t ch, uint16_t val, uint8_t fast);
+static uint16_t MedianSample(volatile uint16_t* pBuf, volatile uint8_t* pPos, uint8_t len, uint16_t val);
+static inline void SortPair(uint16_t* pA, uint16_t* pB);
+static uint16_t CalibrateSample(uint8_t ch, uint16_t val);
+static uint16_t CalibrateFiltered(uint8_t ch, uint16_t q);
+static int16_t CalibrateDrop(int16_t drop, uint16_t bat);
+static uint16_t UncalibrateLimit(uint8_t ch, uint16_t val);
+static void UpdateInverse(uint8_t ch);
+static inline uint8_t WindowSample(uint8_t ch, uint16_t val);
+static uint8_t FreeRunFits(void);
+static inline void StartConversion(uint8_t ch);
 
 
 /**** Public function definitions ****/
@@ -43,8 +150,17 @@ void ADCDRV_Init(uint8_t wake)
 	PORTCR |= 0x04; //Pull-up disable
 	DIDR0 |= 0x0F; //Disable digital inputs
 	ADMUX = 0x40; //Set AVCC reference
-	ADCSRA = 0x03; //ADC Disabled, Single conversion, no IT, 62.5kHz @1MHz
+	ADCSRA = 0x0B; //ADC Disabled, Single conversion, IT enabled, 125kHz @1MHz
 	ADCSRB = 0x00; //no trigger input
+	
+	//Load calibration, erased EEPROM is unity
+	eeprom_read_block(cal,ee_cal,sizeof(cal));
+	for(uint8_t i=0; i<ADC_CH_COUNT; i++)
+	{
+		if(cal[i].gain==0xFFFF){cal[i].gain = ADC_CAL_UNITY; cal[i].offset = 0;};
+		UpdateInverse(i);
+	}
+	
 	if(wake) ADCSRA |= 0x80;  //Enable ADC
 	else PRR |= 0x01;
 }
@@ -65,8 +181,10 @@ void ADCDRV_Wake(void)
  */
 void ADCDRV_Sleep(void)
 {
+	//stop continuous conversions
+	if(mode==ADC_MODE_FREERUN) ADCDRV_StopFreeRun();
 	//wait to finish
-	while(ADCSRA&0x40);
+	while((ADCSRA&0x40)||(!scan_done));
 	//Disable ADC
 	ADCSRA &= ~0x80;
 	//Disable ADC power
@@ -74,36 +192,313 @@ void ADCDRV_Sleep(void)
 }
 
 /**
- * @brief ADC measurement processing
+ * @brief ADC measurement processing, blocking
  */
 void ADCDRV_MeasureAll(void)
+{
+	ADCDRV_StartScan();
+	while(!ADCDRV_GetScanComplete()) ADCDRV_WaitConversion();
+}
+
+/**
+ * @brief Start interrupt driven scan of one frame.
+ * In free-running mode only waits for next buffer swap.
+ */
+void ADCDRV_StartScan(void)
 {
 	//check if ADC is enabled
 	if((PRR&0x01)||(!(ADCSRA&0x80))) return;
 	
-	ADMUX &= ~0x0F;
-	ADMUX |= 0x00;
-	ADCSRA |= 0x40;
-	while(ADCSRA&0x40); //wait to finish
-	bat_mon = ADC;
+	scan_done = 0;
+	if(mode==ADC_MODE_FREERUN) return;
 	
-	ADMUX &= ~0x0F;
-	ADMUX |= 0x01;
-	ADCSRA |= 0x40;
-	while(ADCSRA&0x40); //wait to finish
-	isol_mon = ADC;
+	//Continue from where last scan ended
+	frame_cnt = 0;
+	ApplyResolution();
 	
-	ADMUX &= ~0x0F;
-	ADMUX |= 0x02;
-	ADCSRA |= 0x40;
-	while(ADCSRA&0x40); //wait to finish
-	ign_mon = ADC;
+	StartConversion(scan_list[conv_pos]);
+}
+
+/**
+ * @brief Start continuous, double buffered conversions.
+ * When conversion is shorter than ISR, request is kept and single scans are used.
+ */
+void ADCDRV_StartFreeRun(void)
+{
+	freerun_req = 1;
+	
+	//check if ADC is enabled
+	if((PRR&0x01)||(!(ADCSRA&0x80))) return;
+	if(mode==ADC_MODE_FREERUN) return;
+	if(!FreeRunFits()) return;
+	
+	//wait for running scan to finish
+	while(!scan_done);
 	
+	mux_pos = conv_pos;
+	frame_cnt = 0;
+	scan_done = 0;
+	mode = ADC_MODE_FREERUN;
+	
+	ApplyResolution();
 	ADMUX &= ~0x0F;
-	ADMUX |= 0x03;
-	ADCSRA |= 0x40;
-	while(ADCSRA&0x40); //wait to finish
-	alt_mon = ADC;
+	ADMUX |= scan_list[conv_pos];
+	ADCSRB &= ~0x07; //Free running trigger source
+	ADCSRA |= 0x60; //Auto trigger enable, start first conversion
+}
+
+/**
+ * @brief Stop continuous conversions, return to single scan mode
+ */
+void ADCDRV_StopFreeRun(void)
+{
+	freerun_req = 0;
+	if(mode!=ADC_MODE_FREERUN) return;
+	
+	ADCSRA &= ~0x20; //Auto trigger disable
+	while(ADCSRA&0x40); //wait for last conversion
+	
+	mode = ADC_MODE_SINGLE;
+	scan_done = 1;
+}
+
+/**
+ * @brief Set conversion resolution, applied at next scan
+ * @param [in] resolution ADC_RES_10BIT or ADC_RES_8BIT
+ */
+void ADCDRV_SetResolution(uint8_t resolution)
+{
+	if(res==resolution) return;
+	
+	if(freerun_req)
+	{
+		//Prescaler can't be changed during conversion, new one may not fit ISR
+		ADCDRV_StopFreeRun();
+		res = resolution;
+		ADCDRV_StartFreeRun();
+	}
+	else
+	{
+		res = resolution;
+	}
+}
+
+/**
+ * @brief Set ADC prescaler for CPU clock, applied at next scan
+ * @param [in] cpu_div CPU clock divider, CLKPR CLKPS value [0-8MHz,2-2MHz,3-1MHz]
+ */
+void ADCDRV_SetClock(uint8_t cpu_div)
+{
+	switch(cpu_div)
+	{
+		case 0:
+			adps_precise = 0x06; // /64
+			adps_fast = 0x04; // /16
+			break;
+		
+		case 2:
+			adps_precise = 0x04; // /16
+			adps_fast = 0x02; // /4
+			break;
+		
+		case 3:
+			adps_precise = 0x03; // /8
+			adps_fast = 0x01; // /2
+			break;
+		
+		default:
+			break;
+	}
+}
+
+/**
+ * @brief Set channel scan list, blocking until running conversions finish.
+ * Free-running conversions are restarted with the new list.
+ * @param [in] pList Channel list, conversion order
+ * @param [in] len List length [1 to ADC_SCAN_LIST_MAX]
+ * @param [in] frame Conversions per scan
+ */
+void ADCDRV_SetScanList(const uint8_t* pList, uint8_t len, uint8_t frame)
+{
+	if((len==0)||(len>ADC_SCAN_LIST_MAX)||(frame==0)) return;
+	for(uint8_t i=0; i<len; i++)
+	{
+		if(pList[i]>=ADC_CH_COUNT) return;
+	}
+	
+	//ISR walks the list, finish conversions with old list first
+	uint8_t freerun = (mode==ADC_MODE_FREERUN);
+	if(freerun) ADCDRV_StopFreeRun();
+	else while((ADCSRA&0x40)||(!scan_done));
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for(uint8_t i=0; i<len; i++) scan_list[i] = pList[i];
+		scan_len = len;
+		scan_frame = frame;
+		conv_pos = 0;
+		mux_pos = 0;
+		frame_cnt = 0;
+	}
+	
+	if(freerun) ADCDRV_StartFreeRun();
+}
+
+/**
+ * @brief Set channel median spike filter
+ * @param [in] ch ADC channel
+ * @param [in] len Median length [ADC_MED_NONE/ADC_MED_3/ADC_MED_5]
+ */
+void ADCDRV_SetMedian(uint8_t ch, uint8_t len)
+{
+	if(ch>=ADC_CH_COUNT) return;
+	if((len!=ADC_MED_3)&&(len!=ADC_MED_5)) len = ADC_MED_NONE;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		med_len[ch] = len;
+		med_pos[ch] = 0xFF; //Seed with next sample
+		if(ch==ADC_ALTU)
+		{
+			//Relay drop follows ALT
+			drop_pos[0] = 0xFF;
+			drop_pos[1] = 0xFF;
+		};
+	}
+}
+
+/**
+ * @brief Set channel filter
+ * @param [in] ch ADC channel
+ * @param [in] filt Filter mode [ADC_FILT_NONE/OS4/OS16/EMA]
+ * @param [in] shift EMA smoothing, alpha = 1/2^shift [0 to 6]
+ */
+void ADCDRV_SetFilter(uint8_t ch, uint8_t filt, uint8_t shift)
+{
+	if(ch>=ADC_CH_COUNT) return;
+	if(shift>6) shift = 6;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		filt_mode[ch] = filt;
+		filt_shift[ch] = shift;
+		filt_cnt[ch] = 0;
+		filt_acc[ch] = 0;
+	}
+}
+
+/**
+ * @brief Set channel calibration, applied on next read. Window of the channel
+ * is disarmed, its limits were converted with old coefficients.
+ * @param [in] ch ADC channel
+ * @param [in] gain Gain, Q1.15, ADC_CAL_UNITY is 1.0 [0 to 0xFFFE]
+ * @param [in] offset Offset in ADC LSB, added after gain
+ */
+void ADCDRV_SetCalibration(uint8_t ch, uint16_t gain, int8_t offset)
+{
+	if(ch>=ADC_CH_COUNT) return;
+	if(gain==0xFFFF) gain = 0xFFFE; //Reserved for erased EEPROM
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		cal[ch].gain = gain;
+		cal[ch].offset = offset;
+		UpdateInverse(ch);
+		win_low[ch] = ADC_WIN_LOW_OFF;
+		win_high[ch] = ADC_WIN_HIGH_OFF;
+	}
+}
+
+/**
+ * @brief Write calibration of all channels to EEPROM, blocking
+ */
+void ADCDRV_StoreCalibration(void)
+{
+	AdcCalDef temp[ADC_CH_COUNT];
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		for(uint8_t i=0; i<ADC_CH_COUNT; i++) temp[i] = cal[i];
+	}
+	
+	//Only changed bytes are written
+	eeprom_update_block(temp,ee_cal,sizeof(temp));
+}
+
+/**
+ * @brief Set instant trip window of channel
+ * @param [in] ch ADC channel
+ * @param [in] low Low limit, calibrated counts, ADC_WIN_LOW_OFF-no low trip
+ * @param [in] high High limit, calibrated counts, ADC_WIN_HIGH_OFF-no high trip
+ */
+void ADCDRV_SetWindow(uint8_t ch, uint16_t low, uint16_t high)
+{
+	if(ch>=ADC_CH_COUNT) return;
+	
+	//ISR compares raw samples
+	if(low!=ADC_WIN_LOW_OFF) low = UncalibrateLimit(ch,low);
+	if(high!=ADC_WIN_HIGH_OFF) high = UncalibrateLimit(ch,high);
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		win_low[ch] = low;
+		win_high[ch] = high;
+	}
+}
+
+/**
+ * @brief Set function called from ADC ISR when sample is outside of window
+ * @param [in] pHandler Handler, gets ADC channel, 0-none
+ */
+void ADCDRV_SetWindowHandler(void (*pHandler)(uint8_t ch))
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		pWinHandler = pHandler;
+	}
+}
+
+/**
+ * @brief Start conversions of channel by Timer1 overflow, single scans only.
+ * Timer1 has to run while channel is set, free-running request waits.
+ * @param [in] ch ADC channel, ADC_SYNC_NONE-none
+ */
+void ADCDRV_SetSync(uint8_t ch)
+{
+	if(ch>=ADC_CH_COUNT) ch = ADC_SYNC_NONE;
+	if(sync_ch==ch) return;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		sync_ch = ch;
+		
+		//Conversion waiting for trigger is started now
+		if((mode!=ADC_MODE_FREERUN)&&(ADCSRA&0x20)&&(!(ADCSRA&0x40))) ADCSRA = (ADCSRA&~0x30)|0x40;
+	}
+	
+	//Free-running can't wait for trigger
+	if(freerun_req)
+	{
+		ADCDRV_StopFreeRun();
+		ADCDRV_StartFreeRun();
+	};
+}
+
+/**
+ * @brief Sleep in ADC noise reduction mode until next ADC interrupt
+ */
+void ADCDRV_WaitConversion(void)
+{
+	cli();
+	if(!scan_done)
+	{
+		if((PRR&0x28)==0x28) SMCR = 0x03; //ADC noise reduction mode, sleep enable
+		else SMCR = 0x01; //Timer0 or Timer1 running, Idle mode, sleep enable
+		sei();
+		sleep_cpu(); //sei() guarantees one instruction before any interrupt
+		SMCR = 0x00; //Sleep disable
+	};
+	sei();
 }
 
 /**
@@ -113,22 +508,565 @@ void ADCDRV_MeasureAll(void)
  */
 uint16_t ADCDRV_GetValue(uint8_t ch)
 {
+	uint16_t raw = 0;
+	
+	if(ch>=ADC_CH_COUNT) return 0;
+	
+	//ISR may copy buffers in free-running mode
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		raw = adc_frame[ch];
+	}
+	
 	//convert values to mV return
-	switch(ch)
+	return CalibrateSample(ch,raw)*20;
+}
+
+/**
+ * @brief Get calibrated channel counts
+ * @param [in] ch - ADC channel to read
+ * @return Calibrated ADC counts, 20mV/LSB
+ */
+uint16_t ADCDRV_GetCounts(uint8_t ch)
+{
+	uint16_t raw = 0;
+	
+	if(ch>=ADC_CH_COUNT) return 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		case 0:
-		return bat_mon*20;
-		
-		case 1:
-		return isol_mon*20;
+		raw = adc_frame[ch];
+	}
+	
+	return CalibrateSample(ch,raw);
+}
+
+/**
+ * @brief Get channel value from fast scan
+ * @param [in] ch - ADC channel to read
+ * @return 8bit ADC channel value, 80mV/LSB
+ */
+uint8_t ADCDRV_GetFastValue(uint8_t ch)
+{
+	if(ch>=ADC_CH_COUNT) return 0;
+	
+	return (uint8_t)(CalibrateSample(ch,((uint16_t)fast_frame[ch])<<2)>>2);
+}
+
+/**
+ * @brief Get skew compensated relay drop magnitude in calibrated counts
+ * @return Relay drop |ALT-BAT|, 20mV/LSB
+ */
+uint16_t ADCDRV_GetRelayDropCounts(void)
+{
+	int16_t drop = 0;
+	uint16_t bat = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		drop = drop_frame;
+		bat = adc_frame[ADC_BATU];
+	}
+	
+	drop = CalibrateDrop(drop,bat);
+	
+	//Half LSB to LSB
+	if(drop<0) drop = -drop;
+	return (uint16_t)drop>>1;
+}
+
+/**
+ * @brief Get skew compensated relay drop magnitude in fast ADC units
+ * @return Relay drop |ALT-BAT|, 8bit ADC value, 80mV/LSB
+ */
+uint8_t ADCDRV_GetFastRelayDrop(void)
+{
+	int16_t drop = 0;
+	uint16_t bat = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		drop = drop_frame;
+		bat = ((uint16_t)fast_frame[ADC_BATU])<<2;
+	}
+	
+	drop = CalibrateDrop(drop,bat);
+	
+	//Half LSB to 8bit LSB
+	if(drop<0) drop = -drop;
+	return (uint8_t)(drop>>3);
+}
+
+/**
+ * @brief Get filtered channel value
+ * @param [in] ch - ADC channel to read
+ * @return Filtered ADC channel value in mV
+ */
+uint16_t ADCDRV_GetFiltered(uint8_t ch)
+{
+	uint16_t q = 0;
+	
+	if(ch>=ADC_CH_COUNT) return 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		q = filt_val[ch];
+	}
+	
+	//Q10.6 to mV, 20mV/LSB = (q>>4)*5
+	return (CalibrateFiltered(ch,q)>>4)*5;
+}
+
+/**
+ * @brief Get filtered channel counts
+ * @param [in] ch - ADC channel to read
+ * @return Filtered calibrated ADC counts, Q10.6 (1/64 LSB)
+ */
+uint16_t ADCDRV_GetFilteredCounts(uint8_t ch)
+{
+	uint16_t q = 0;
+	
+	if(ch>=ADC_CH_COUNT) return 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		q = filt_val[ch];
+	}
+	
+	return CalibrateFiltered(ch,q);
+}
+
+/**
+ * @brief Get channel sample age
+ * @param [in] ch - ADC channel
+ * @return Conversions since channel was sampled, at end of last scan [0-last conversion]
+ */
+uint8_t ADCDRV_GetSampleAge(uint8_t ch)
+{
+	uint8_t age = 0;
+	
+	if(ch>=ADC_CH_COUNT) return 255;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		age = frame_stamp-stamp_frame[ch];
+	}
+	
+	return age;
+}
+
+/**
+ * @brief Get channel scan status
+ * @return Scan complete flag [0-in progress,1-complete/new buffer]
+ */
+uint8_t ADCDRV_GetScanComplete(void)
+{
+	return scan_done;
+}
+
+/**
+ * @brief Get requested conversion mode, free-running may run as single scans
+ * @return ADC_MODE_SINGLE or ADC_MODE_FREERUN
+ */
+uint8_t ADCDRV_GetMode(void)
+{
+	if(freerun_req) return ADC_MODE_FREERUN;
+	else return ADC_MODE_SINGLE;
+}
+
+/**** Private function definitions ****/
+/**
+ * @brief Median spike filter stage
+ * @param [in,out] pBuf History, ADC_MED_BUF entries
+ * @param [in,out] pPos History position, out of range-seed with this sample
+ * @param [in] len Median length [ADC_MED_NONE/ADC_MED_3/ADC_MED_5]
+ * @param [in] val New sample
+ * @return Median of last N samples
+ */
+static uint16_t MedianSample(volatile uint16_t* pBuf, volatile uint8_t* pPos, uint8_t len, uint16_t val)
+{
+	uint16_t p[ADC_MED_BUF];
+	uint8_t pos = *pPos;
+	
+	if(len==ADC_MED_NONE) return val;
+	
+	if(pos>=ADC_MED_BUF)
+	{
+		//Seed history with first sample
+		for(uint8_t i=0; i<ADC_MED_BUF; i++) pBuf[i] = val;
+		pos = 0;
+	};
+	
+	pBuf[pos] = val;
+	pos++;
+	if(pos>=len) pos = 0;
+	*pPos = pos;
+	
+	p[0] = pBuf[0];
+	p[1] = pBuf[1];
+	p[2] = pBuf[2];
+	
+	if(len==ADC_MED_3)
+	{
+		SortPair(&p[0],&p[1]);
+		SortPair(&p[1],&p[2]);
+		SortPair(&p[0],&p[1]);
+		return p[1];
+	};
+	
+	p[3] = pBuf[3];
+	p[4] = pBuf[4];
+	
+	SortPair(&p[0],&p[1]);
+	SortPair(&p[3],&p[4]);
+	SortPair(&p[0],&p[3]);
+	SortPair(&p[1],&p[4]);
+	SortPair(&p[1],&p[2]);
+	SortPair(&p[2],&p[3]);
+	SortPair(&p[1],&p[2]);
+	return p[2];
+}
+
+/**
+ * @brief Calibrate raw value, gain and offset
+ * @param [in] ch ADC channel
+ * @param [in] val Raw ADC counts, 10bit scale
+ * @return Calibrated counts, limited to 10bit
+ */
+static uint16_t CalibrateSample(uint8_t ch, uint16_t val)
+{
+	int16_t x = val;
+	
+	if(cal[ch].gain!=ADC_CAL_UNITY) x = (int16_t)(((uint32_t)val*cal[ch].gain)>>15);
+	x += cal[ch].offset;
+	
+	if(x<0) return 0;
+	if(x>0x3FF) return 0x3FF;
+	return (uint16_t)x;
+}
+
+/**
+ * @brief Calibrate raw filtered value, gain and offset
+ * @param [in] ch ADC channel
+ * @param [in] q Raw filtered counts, Q10.6
+ * @return Calibrated filtered counts, Q10.6
+ */
+static uint16_t CalibrateFiltered(uint8_t ch, uint16_t q)
+{
+	int32_t x = q;
+	
+	if(cal[ch].gain!=ADC_CAL_UNITY) x = (int32_t)(((uint32_t)q*cal[ch].gain)>>15);
+	x += (int16_t)cal[ch].offset*64;
+	
+	if(x<0) return 0;
+	if(x>0xFFC0) return 0xFFC0;
+	return (uint16_t)x;
+}
+
+/**
+ * @brief Calibrate raw relay drop, ALT and BAT gain and offset
+ * @param [in] drop Raw drop ALT-BAT, half LSB
+ * @param [in] bat Raw BAT counts of same frame, 10bit scale
+ * @return Calibrated drop, half LSB
+ */
+static int16_t CalibrateDrop(int16_t drop, uint16_t bat)
+{
+	const AdcCalDef* pAlt = &cal[ADC_ALTU];
+	const AdcCalDef* pBat = &cal[ADC_BATU];
+	
+	//cal(ALT)-cal(BAT) = ga*drop + (ga-gb)*BAT + offset difference
+	if((pAlt->gain!=ADC_CAL_UNITY)||(pBat->gain!=ADC_CAL_UNITY))
+	{
+		int32_t x = (int32_t)drop*pAlt->gain;
+		x += ((int32_t)pAlt->gain-(int32_t)pBat->gain)*(int32_t)(bat<<1);
+		drop = (int16_t)(x>>15);
+	};
+	
+	return drop+((pAlt->offset-pBat->offset)<<1);
+}
+
+/**
+ * @brief Convert calibrated limit to raw counts, inverse of calibration
+ * @param [in] ch ADC channel
+ * @param [in] val Calibrated counts, 10bit scale
+ * @return Raw counts, limited to 10bit
+ */
+static uint16_t UncalibrateLimit(uint8_t ch, uint16_t val)
+{
+	int16_t x = (int16_t)val-cal[ch].offset;
+	
+	if(x<0) return 0;
+	if(cal[ch].gain!=ADC_CAL_UNITY) x = (int16_t)(((uint32_t)x*cal_inv[ch])>>15);
+	
+	if(x>0x3FF) return 0x3FF;
+	return (uint16_t)x;
+}
+
+/**
+ * @brief Compute inverse gain of channel, once per coefficient change
+ * @param [in] ch ADC channel
+ */
+static void UpdateInverse(uint8_t ch)
+{
+	//Q1.15 inverse, gains below 0.5 saturate
+	uint32_t inv = 0xFFFF;
+	if(cal[ch].gain>=0x4001) inv = (1UL<<30)/cal[ch].gain;
+	cal_inv[ch] = (uint16_t)inv;
+}
+
+/**
+ * @brief Instant trip window stage, handler when re-conversion is outside too
+ * @param [in] ch ADC channel
+ * @param [in] val Raw sample, 10bit scale
+ * @return Sample has to be confirmed, convert channel again [0-no,1-yes]
+ */
+static inline uint8_t WindowSample(uint8_t ch, uint16_t val)
+{
+	if((val<=win_high[ch])&&(val>=win_low[ch]))
+	{
+		win_retry = 0;
+		return 0;
+	};
+	
+	//Free-running conversion of next channel is already running
+	if((!win_retry)&&(mode!=ADC_MODE_FREERUN))
+	{
+		win_retry = 1;
+		return 1;
+	};
+	
+	win_retry = 0;
+	void (*pHandler)(uint8_t ch) = pWinHandler;
+	if(pHandler) pHandler(ch);
+	return 0;
+}
+
+/**
+ * @brief Compare-swap, smaller value to A
+ * @param [in,out] pA First value
+ * @param [in,out] pB Second value
+ */
+static inline void SortPair(uint16_t* pA, uint16_t* pB)
+{
+	uint16_t a = *pA;
+	uint16_t b = *pB;
+	
+	if(a>b){*pA = b; *pB = a;};
+}
+
+/**
+ * @brief Relay drop from paired BAT/ALT samples, median on drop
+ * @param [in] ch ADC channel
+ * @param [in] val ADC sample before median, 10bit scale
+ * @param [in] fast Sample resolution [ADC_RES_10BIT/ADC_RES_8BIT]
+ */
+static void PairSample(uint8_t ch, uint16_t val, uint8_t fast)
+{
+	int16_t drop = 0;
+	uint8_t paired = 1;
+	
+	if((ch==ADC_ALTU)&&(hist_ch[0]==ADC_BATU))
+	{
+		if(hist_ch[1]==ADC_ALTU) drop = (val+hist_val[1])-(hist_val[0]<<1); //ALT-BAT-ALT
+		else drop = (val-hist_val[0])<<1; //BAT-ALT
+	}
+	else if((ch==ADC_BATU)&&(hist_ch[0]==ADC_ALTU))
+	{
+		if(hist_ch[1]==ADC_BATU) drop = (hist_val[0]<<1)-(val+hist_val[1]); //BAT-ALT-BAT
+		else drop = (hist_val[0]-val)<<1; //ALT-BAT
+	}
+	else paired = 0;
+	
+	if(paired)
+	{
+		//Spike rejection on drop, history of this resolution only
+		uint16_t med = MedianSample(drop_med[fast],&drop_pos[fast],med_len[ADC_ALTU],(uint16_t)(drop+ADC_DROP_BIAS));
+		drop_live = (int16_t)med-ADC_DROP_BIAS;
+	};
+	
+	hist_ch[1] = hist_ch[0];
+	hist_val[1] = hist_val[0];
+	hist_ch[0] = ch;
+	hist_val[0] = val;
+}
+
+/**
+ * @brief Check free-running conversion of selected resolution against ISR budget
+ * @return Conversion is longer than worst case ISR [0-no,1-yes]
+ */
+static uint8_t FreeRunFits(void)
+{
+	//Synchronized channel waits for trigger
+	if(sync_ch!=ADC_SYNC_NONE) return 0;
+	
+	uint8_t adps = adps_precise;
+	if(res==ADC_RES_8BIT) adps = adps_fast;
+	
+	//ADC clock is CPU clock/2^ADPS
+	if(((uint16_t)ADC_CONV_CLK<<adps)<ADC_ISR_CYCLES) return 0;
+	else return 1;
+}
+
+/**
+ * @brief Start conversion of channel, synchronized channel waits for Timer1 overflow
+ * @param [in] ch ADC channel
+ */
+static inline void StartConversion(uint8_t ch)
+{
+	ADMUX = (ADMUX&~0x0F)|ch;
+	
+	if(ch==sync_ch)
+	{
+		//Trigger is rising edge of TOV1, flag is cleared after enable
+		ADCSRB = (ADCSRB&~0x07)|0x06; //Timer1 overflow trigger source
+		ADCSRA = (ADCSRA&~0x10)|0x20; //Auto trigger enable, don't clear ADIF
+		TIFR1 = 0x01;
+	}
+	else
+	{
+		ADCSRA = (ADCSRA&~0x30)|0x40; //Auto trigger off, start conversion
+	};
+}
+
+/**
+ * @brief Set ADC clock and result adjustment for selected resolution
+ */
+static void ApplyResolution(void)
+{
+	//Don't pair samples of different resolution
+	hist_ch[0] = 0xFF;
+	hist_ch[1] = 0xFF;
+	
+	if(res==ADC_RES_8BIT)
+	{
+		ADMUX |= 0x20; //Left adjust result
+		ADCSRA = (ADCSRA&~0x17)|adps_fast; //500kHz, don't clear ADIF
+	}
+	else
+	{
+		ADMUX &= ~0x20; //Right adjust result
+		ADCSRA = (ADCSRA&~0x17)|adps_precise; //125kHz, don't clear ADIF
+	}
+}
+
+/**
+ * @brief Channel filter stage
+ * @param [in] ch ADC channel
+ * @param [in] raw ADC sample
+ */
+static void FilterSample(uint8_t ch, uint16_t raw)
+{
+	uint16_t x = raw<<6;
+	uint16_t y = filt_val[ch];
+	
+	switch(filt_mode[ch])
+	{
+		case ADC_FILT_OS4:
+			filt_acc[ch] += raw;
+			filt_cnt[ch]++;
+			if(filt_cnt[ch]>=4)
+			{
+				filt_val[ch] = filt_acc[ch]<<4;
+				filt_acc[ch] = 0;
+				filt_cnt[ch] = 0;
+			};
+			break;
 		
-		case 2:
-		return ign_mon*20;
+		case ADC_FILT_OS16:
+			filt_acc[ch] += raw;
+			filt_cnt[ch]++;
+			if(filt_cnt[ch]>=16)
+			{
+				filt_val[ch] = filt_acc[ch]<<2;
+				filt_acc[ch] = 0;
+				filt_cnt[ch] = 0;
+			};
+			break;
 		
-		case 3:
-		return alt_mon*20;
+		case ADC_FILT_EMA:
+			if(!filt_cnt[ch])
+			{
+				//Seed with first sample
+				y = x;
+				filt_cnt[ch] = 1;
+			}
+			else if(x>y) y += (x-y)>>filt_shift[ch];
+			else y -= (y-x)>>filt_shift[ch];
+			filt_val[ch] = y;
+			break;
 		
 		default:
-		return 0;
+			filt_val[ch] = x;
+			break;
 	}
 }
+
+/**** Interrupt handlers ****/
+/**
+ * @brief ADC conversion complete, store result and start next channel
+ */
+ISR(ADC_vect)
+{
+	uint8_t ch = scan_list[conv_pos];
+	uint16_t raw = 0;
+	
+	if(ADMUX&0x20) raw = ((uint16_t)ADCH)<<2;
+	else raw = ADC;
+	
+	//Outside of window, sample is dropped and confirmed back-to-back
+	if(WindowSample(ch,raw))
+	{
+		StartConversion(ch);
+		return;
+	};
+	
+	conv_cnt++;
+	if(ADMUX&0x20)
+	{
+		//Fast 8bit conversion, no channel median
+		PairSample(ch,raw,ADC_RES_8BIT);
+		fast_live[ch] = (uint8_t)(raw>>2);
+		stamp_live[ch] = conv_cnt;
+	}
+	else
+	{
+		PairSample(ch,raw,ADC_RES_10BIT);
+		raw = MedianSample(med_buf[ch],&med_pos[ch],med_len[ch],raw);
+		adc_live[ch] = raw;
+		stamp_live[ch] = conv_cnt;
+		FilterSample(ch,raw);
+	};
+	
+	if(mode==ADC_MODE_FREERUN)
+	{
+		//Next conversion already uses mux_pos, move mux one entry ahead
+		conv_pos = mux_pos;
+		mux_pos++;
+		if(mux_pos>=scan_len) mux_pos = 0;
+		ADMUX &= ~0x0F;
+		ADMUX |= scan_list[mux_pos];
+	}
+	else
+	{
+		conv_pos++;
+		if(conv_pos>=scan_len) conv_pos = 0;
+		if((frame_cnt+1)<scan_frame) StartConversion(scan_list[conv_pos]);
+		else ADCSRA &= ~0x20; //No trigger armed between scans
+	};
+	
+	frame_cnt++;
+	if(frame_cnt>=scan_frame)
+	{
+		//Copy live buffer to front buffer
+		for(uint8_t i=0; i<ADC_CH_COUNT; i++)
+		{
+			adc_frame[i] = adc_live[i];
+			stamp_frame[i] = stamp_live[i];
+			fast_frame[i] = fast_live[i];
+		}
+		drop_frame = drop_live;
+		frame_stamp = conv_cnt;
+		frame_cnt = 0;
+		scan_done = 1;
+	};
+}
\ No newline at end of file
@@ -6,6 +6,18 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Interrupt driven channel scan with ADC noise reduction sleep
+2026-10-16: Free-running double buffered mode
+2026-10-16: Per-channel oversampling/EMA filter stage
+2026-10-16: Priority weighted scan list, sample age
+2026-10-16: Fast 8bit left adjusted scan mode
+2026-10-16: Skew compensated relay drop from paired BAT/ALT samples
+2026-10-16: Median of 3/5 spike filter
+2026-10-16: Per-channel gain/offset calibration from EEPROM
+2026-10-16: ADC prescaler follows CPU clock divider
+2026-10-16: Instant trip window check in conversion ISR
+2026-10-16: Relay drop of precise scans in calibrated counts
+2026-10-16: Channel conversion synchronized to Timer1 overflow
 */
 
 #ifndef ADC_DRIVER
@@ -19,16 +31,71 @@ Revision history:
 #define ADC_IGNC	2
 #define ADC_ALTU	3
 
+#define ADC_SCAN_LIST_MAX	16
+#define ADC_SCAN_FRAME		4
+
+#define ADC_MODE_SINGLE		0
+#define ADC_MODE_FREERUN	1
+
+#define ADC_RES_10BIT	0
+#define ADC_RES_8BIT	1
+
+#define ADC_SYNC_NONE	0xFF	//No channel synchronized to Timer1
+
+#define ADC_WIN_LOW_OFF		0		//Window low limit, no trip
+#define ADC_WIN_HIGH_OFF	0x3FF	//Window high limit, no trip
+
+//Convert mV to fast 8bit ADC value, 80mV/LSB
+#define ADC_MV_TO_FAST(mv)	(((mv)+40)/80)
+//Convert mV to calibrated 10bit ADC counts, 20mV/LSB
+#define ADC_MV_TO_COUNTS(mv)	(((mv)+10)/20)
+//Convert mV to filtered ADC counts, Q10.6
+#define ADC_MV_TO_FILT(mv)	((uint16_t)((((uint32_t)(mv))*16+2)/5))
+
+#define ADC_CAL_UNITY	0x8000
+
+#define ADC_MED_NONE	0
+#define ADC_MED_3		3
+#define ADC_MED_5		5
+
+#define ADC_FILT_NONE	0
+#define ADC_FILT_OS4	1
+#define ADC_FILT_OS16	2
+#define ADC_FILT_EMA	3
+
 /**** Public function declarations ****/
 //Control functions
 void ADCDRV_Init(uint8_t wake);
 void ADCDRV_Wake(void);
 void ADCDRV_Sleep(void);
+void ADCDRV_StartFreeRun(void);
+void ADCDRV_StopFreeRun(void);
+void ADCDRV_SetResolution(uint8_t resolution);
+void ADCDRV_SetClock(uint8_t cpu_div);
+void ADCDRV_SetScanList(const uint8_t* pList, uint8_t len, uint8_t frame);
+void ADCDRV_SetMedian(uint8_t ch, uint8_t len);
+void ADCDRV_SetFilter(uint8_t ch, uint8_t filt, uint8_t shift);
+void ADCDRV_SetCalibration(uint8_t ch, uint16_t gain, int8_t offset);
+void ADCDRV_StoreCalibration(void);
+void ADCDRV_SetWindow(uint8_t ch, uint16_t low, uint16_t high);
+void ADCDRV_SetWindowHandler(void (*pHandler)(uint8_t ch));
+void ADCDRV_SetSync(uint8_t ch);
 
 //Interrupt and loop functions
 void ADCDRV_MeasureAll(void);
+void ADCDRV_StartScan(void);
+void ADCDRV_WaitConversion(void);
 
 //Data retrieve functions
 uint16_t ADCDRV_GetValue(uint8_t ch);
+uint16_t ADCDRV_GetCounts(uint8_t ch);
+uint8_t ADCDRV_GetFastValue(uint8_t ch);
+uint16_t ADCDRV_GetFiltered(uint8_t ch);
+uint16_t ADCDRV_GetFilteredCounts(uint8_t ch);
+uint16_t ADCDRV_GetRelayDropCounts(void);
+uint8_t ADCDRV_GetFastRelayDrop(void);
+uint8_t ADCDRV_GetSampleAge(uint8_t ch);
+uint8_t ADCDRV_GetScanComplete(void);
+uint8_t ADCDRV_GetMode(void);
 
 #endif
\ No newline at end of file
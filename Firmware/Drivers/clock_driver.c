@@ -0,0 +1,89 @@
+/*
+Battery isolator controller
+CPU clock driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, CLKPR clock scaling
+2026-10-16: Free-running request kept over clock change
+2026-10-16: Short driver description
+*/
+
+/**** Hardware configuration ****
+Internal 8MHz oscillator, CKDIV8 fuse, 1MHz after reset.
+CPU clock = 8MHz/2^CLKPS
+
+Only dividers with exact 1ms system tick are supported: 1, 4 and 8. ADC
+prescaler and Timer0 follow the clock, conversions are finished before change.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include <util/atomic.h>
+#include "adc_driver.h"
+#include "systick_driver.h"
+#include "clock_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+static uint8_t clk_div = CLK_1MHZ;
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes CPU clock to 1MHz, drivers start with 1MHz settings
+ */
+void CLKDRV_Init(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		CLKPR = 0x80; //Change enable
+		CLKPR = CLK_1MHZ; //Within 4 cycles
+	}
+	clk_div = CLK_1MHZ;
+}
+
+/**
+ * @brief Set CPU clock, ADC and system tick are reconfigured
+ * @param [in] div CPU clock [CLK_8MHZ/CLK_2MHZ/CLK_1MHZ]
+ */
+void CLKDRV_SetSpeed(uint8_t div)
+{
+	if((div!=CLK_8MHZ)&&(div!=CLK_2MHZ)&&(div!=CLK_1MHZ)) return;
+	if(div==clk_div) return;
+	
+	//Finish conversions with old ADC clock, free-running request may run as single scans
+	uint8_t freerun = (ADCDRV_GetMode()==ADC_MODE_FREERUN);
+	if(freerun) ADCDRV_StopFreeRun();
+	while(!ADCDRV_GetScanComplete()) ADCDRV_WaitConversion();
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		CLKPR = 0x80; //Change enable
+		CLKPR = div; //Within 4 cycles
+		TICKDRV_SetClock(div);
+	}
+	ADCDRV_SetClock(div);
+	clk_div = div;
+	
+	if(freerun) ADCDRV_StartFreeRun();
+}
+
+/**
+ * @brief Get CPU clock setting
+ * @return CPU clock [CLK_8MHZ/CLK_2MHZ/CLK_1MHZ]
+ */
+uint8_t CLKDRV_GetSpeed(void)
+{
+	return clk_div;
+}
+
+/**
+ * @brief Get CPU clock frequency
+ * @return CPU clock in kHz
+ */
+uint16_t CLKDRV_GetFrequency(void)
+{
+	return 8000>>clk_div;
+}
@@ -0,0 +1,32 @@
+/*
+Battery isolator controller
+CPU clock driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, CLKPR clock scaling
+*/
+
+#ifndef CLOCK_DRIVER
+#define CLOCK_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define CLK_8MHZ	0
+#define CLK_2MHZ	2
+#define CLK_1MHZ	3
+
+/**** Public function declarations ****/
+//Control functions
+void CLKDRV_Init(void);
+void CLKDRV_SetSpeed(uint8_t div);
+
+//Interrupt and loop functions
+
+//Data retrieve functions
+uint8_t CLKDRV_GetSpeed(void);
+uint16_t CLKDRV_GetFrequency(void);
+
+#endif
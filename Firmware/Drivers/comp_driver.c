@@ -0,0 +1,191 @@
+/*
+Battery isolator controller
+Analog comparator driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, one-shot trip on AIN1 against bandgap or AIN0
+2026-10-16: Description follows single scan ADC timing
+2026-10-16: Short driver description
+*/
+
+/**** Hardware configuration ****
+PD6 - AIN0 - Comparator positive input, external reference (CMP_REF_AIN0)
+PD7 - AIN1 - Comparator negative input, monitored voltage
+
+ACO = 1 when positive input (reference) is above AIN1.
+*/
+
+/**** Description ****
+Comparator watches AIN1 continuously, also in Idle sleep, backing up sampled
+protection between ADC scans. ADC is enabled in every active state, so ADC mux
+input (ACME) isn't available, monitored voltage has to be on AIN1. Trip is
+one-shot, ISR disarms comparator and calls handler, Arm returns 1 if input is
+already beyond reference.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include "comp_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+static uint8_t ref_sel = CMP_REF_BANDGAP;
+static volatile uint8_t enabled = 0;
+static volatile uint8_t armed = CMP_TRIP_NONE;
+static volatile uint8_t trip_cnt = 0;
+static void (* volatile pTripHandler)(void) = 0;
+
+/**** Private function declarations ****/
+static void HAL_Enable(void);
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes comparator, not armed
+ * @param [in] ref Reference [CMP_REF_BANDGAP,CMP_REF_AIN0]
+ */
+void CMPDRV_Init(uint8_t ref)
+{
+	ref_sel = ref;
+	
+	//Analog pins, no pull-up, no digital input
+	PORTD &= ~0xC0;
+	DDRD &= ~0xC0;
+	DIDR1 |= 0x03; //AIN1D, AIN0D
+	
+	ADCSRB &= ~0x40; //ACME off, AIN1 is negative input
+	
+	HAL_Enable();
+}
+
+/**
+ * @brief Power comparator and reference after sleep, not armed
+ */
+void CMPDRV_Wake(void)
+{
+	HAL_Enable();
+}
+
+/**
+ * @brief Disarm and power down comparator and bandgap
+ */
+void CMPDRV_Sleep(void)
+{
+	CMPDRV_Disarm();
+	
+	ACSR = 0x80; //ACD, comparator off, bandgap released
+	enabled = 0;
+}
+
+/**
+ * @brief Set function called from comparator ISR on trip
+ * @param [in] pHandler Handler, 0-none
+ */
+void CMPDRV_SetHandler(void (*pHandler)(void))
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		pTripHandler = pHandler;
+	}
+}
+
+/**
+ * @brief Arm one-shot trip
+ * @param [in] trip Trip direction [CMP_TRIP_ABOVE,CMP_TRIP_BELOW], CMP_TRIP_NONE-disarm
+ * @return Input already beyond reference [0-no,1-yes, not armed]
+ */
+uint8_t CMPDRV_Arm(uint8_t trip)
+{
+	if((!enabled)||(trip==CMP_TRIP_NONE))
+	{
+		CMPDRV_Disarm();
+		return 0;
+	};
+	
+	uint8_t acsr = ACSR&~0x0F;
+	
+	ACSR = acsr; //Interrupt off while edge is changed
+	armed = CMP_TRIP_NONE;
+	if(trip==CMP_TRIP_ABOVE)
+	{
+		acsr |= 0x02; //Falling ACO, AIN1 rises above reference
+		if(!(ACSR&0x20)) return 1;
+	}
+	else
+	{
+		acsr |= 0x03; //Rising ACO, AIN1 falls below reference
+		if(ACSR&0x20) return 1;
+	};
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ACSR = acsr|0x10; //Set edge, clear stale flag
+		ACSR = acsr|0x08; //Interrupt enable
+		armed = trip;
+	}
+	
+	return 0;
+}
+
+/**
+ * @brief Disarm trip
+ */
+void CMPDRV_Disarm(void)
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ACSR &= ~0x08;
+		armed = CMP_TRIP_NONE;
+	}
+}
+
+/**
+ * @brief Get armed trip direction
+ * @return Trip direction, CMP_TRIP_NONE if not armed
+ */
+uint8_t CMPDRV_GetArmed(void)
+{
+	return armed;
+}
+
+/**
+ * @brief Get trip count
+ * @return Comparator trips since init, wraps
+ */
+uint8_t CMPDRV_GetTripCount(void)
+{
+	return trip_cnt;
+}
+
+/**** Private function definitions ****/
+/**
+ * @brief Power comparator, select reference
+ */
+static void HAL_Enable(void)
+{
+	if(ref_sel==CMP_REF_BANDGAP) ACSR = 0x40; //ACBG, bandgap on positive input
+	else ACSR = 0x00; //AIN0 on positive input
+	
+	ACSR |= 0x10; //Clear flag
+	armed = CMP_TRIP_NONE;
+	enabled = 1;
+}
+
+/**** Interrupt handlers ****/
+/**
+ * @brief Comparator output toggled in armed direction
+ */
+ISR(ANALOG_COMP_vect)
+{
+	//One-shot
+	ACSR &= ~0x08;
+	armed = CMP_TRIP_NONE;
+	trip_cnt++;
+	
+	void (*pHandler)(void) = pTripHandler;
+	if(pHandler) pHandler();
+}
@@ -0,0 +1,37 @@
+/*
+Battery isolator controller
+Analog comparator driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, one-shot trip on AIN1 against bandgap or AIN0
+*/
+
+#ifndef COMP_DRIVER
+#define COMP_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define CMP_REF_BANDGAP	0	//1.1V internal reference
+#define CMP_REF_AIN0	1	//External reference on AIN0 (PD6)
+
+#define CMP_TRIP_NONE	0
+#define CMP_TRIP_ABOVE	1	//Trip when input rises above reference
+#define CMP_TRIP_BELOW	2	//Trip when input falls below reference
+
+/**** Public function declarations ****/
+//Control functions
+void CMPDRV_Init(uint8_t ref);
+void CMPDRV_Wake(void);
+void CMPDRV_Sleep(void);
+void CMPDRV_SetHandler(void (*pHandler)(void));
+uint8_t CMPDRV_Arm(uint8_t trip);
+void CMPDRV_Disarm(void);
+
+//Data retrieve functions
+uint8_t CMPDRV_GetArmed(void);
+uint8_t CMPDRV_GetTripCount(void);
+
+#endif
@@ -0,0 +1,100 @@
+/*
+Battery isolator controller
+I2t thermal model over-current protection
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, drop squared table, exponential cooling
+2026-10-16: Short driver description
+*/
+
+/**** Description ****
+Drop squared is proportional to dissipated power. Each update adds drop^2 from
+table to heat and removes heat/2^tau. Trip level is just above settled heat of
+limit drop, so limit drop never trips and higher drop trips faster with its
+square. Drop in 40mV units, no multiply or divide at run time.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "i2t_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+//drop^2/4, drop in 40mV units
+static const uint16_t sq_lut[I2T_LUT_SIZE] PROGMEM = {
+	0, 0, 1, 2, 4, 6, 9, 12,
+	16, 20, 25, 30, 36, 42, 49, 56,
+	64, 72, 81, 90, 100, 110, 121, 132,
+	144, 156, 169, 182, 196, 210, 225, 240,
+	256, 272, 289, 306, 324, 342, 361, 380,
+	400, 420, 441, 462, 484, 506, 529, 552,
+	576, 600, 625, 650, 676, 702, 729, 756,
+	784, 812, 841, 870, 900, 930, 961, 992
+};
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes I2t accumulator
+ * @param [in] pAcc Accumulator
+ * @param [in] limit Continuous drop limit, 40mV units [1 to I2T_LUT_SIZE-1]
+ * @param [in] tau Cooling time constant, 2^tau updates [0 to I2T_TAU_MAX]
+ */
+void I2TDRV_Init(i2tDef* pAcc, uint8_t limit, uint8_t tau)
+{
+	if(limit>=I2T_LUT_SIZE) limit = I2T_LUT_SIZE-1;
+	if(tau>I2T_TAU_MAX) tau = I2T_TAU_MAX;
+	
+	//Settled heat of limit drop plus one cooling step
+	pAcc->trip = (pgm_read_word(&sq_lut[limit])+1)<<tau;
+	pAcc->tau = tau;
+	pAcc->heat = 0;
+}
+
+/**
+ * @brief Clear accumulated heat
+ * @param [in] pAcc Accumulator
+ */
+void I2TDRV_Reset(i2tDef* pAcc)
+{
+	pAcc->heat = 0;
+}
+
+/**
+ * @brief Add one update period of heating and cooling
+ * @param [in] pAcc Accumulator
+ * @param [in] drop Voltage drop, 40mV units
+ * @return Trip [0-no,1-heat over trip level]
+ */
+uint8_t I2TDRV_Update(i2tDef* pAcc, uint16_t drop)
+{
+	uint16_t heat = pAcc->heat;
+	
+	if(drop>=I2T_LUT_SIZE) drop = I2T_LUT_SIZE-1;
+	
+	//Exponential cooling
+	heat -= heat>>pAcc->tau;
+	
+	//Heating, saturated add
+	uint16_t inc = pgm_read_word(&sq_lut[drop]);
+	if(inc>(0xFFFF-heat)) heat = 0xFFFF;
+	else heat += inc;
+	
+	pAcc->heat = heat;
+	
+	if(heat>=pAcc->trip) return 1;
+	else return 0;
+}
+
+/**
+ * @brief Get accumulated heat
+ * @param [in] pAcc Accumulator
+ * @return Heat, drop^2/4 units
+ */
+uint16_t I2TDRV_GetHeat(const i2tDef* pAcc)
+{
+	return pAcc->heat;
+}
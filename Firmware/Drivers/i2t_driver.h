@@ -0,0 +1,44 @@
+/*
+Battery isolator controller
+I2t thermal model over-current protection
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, drop squared table, exponential cooling
+2026-10-16: No filtered value conversion, relay drop is unfiltered
+*/
+
+#ifndef I2T_DRIVER
+#define I2T_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define I2T_LUT_SIZE	64	//Drop table range, larger drops are saturated
+#define I2T_TAU_MAX		6	//Max cooling shift, heat stays in 16bit
+
+//Convert mV to I2t drop units, 40mV/LSB
+#define I2T_MV_TO_DROP(mv)	(((mv)+20)/40)
+//Convert ADC values to I2t drop units
+#define I2T_FROM_COUNTS(c)	((uint16_t)(c)>>1)
+#define I2T_FROM_FAST(c)	((uint16_t)(c)<<1)
+
+typedef struct i2tStruct {
+	uint16_t heat;
+	uint16_t trip;
+	uint8_t tau; //Cooling time constant 2^tau updates
+}i2tDef;
+
+/**** Public function declarations ****/
+//Control functions
+void I2TDRV_Init(i2tDef* pAcc, uint8_t limit, uint8_t tau);
+void I2TDRV_Reset(i2tDef* pAcc);
+
+//Interrupt and loop functions
+uint8_t I2TDRV_Update(i2tDef* pAcc, uint16_t drop);
+
+//Data retrieve functions
+uint16_t I2TDRV_GetHeat(const i2tDef* pAcc);
+
+#endif
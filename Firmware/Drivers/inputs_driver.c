@@ -6,6 +6,15 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Pin change wake-up from power-down
+2026-10-16: Strobed pull-up supplies
+2026-10-16: Pin change kill capture with timestamp and glitch confirmation
+2026-10-16: Input descriptor table, bit-parallel vertical counter debouncer
+2026-10-16: Separate assert/release limits, integrating debounce mode
+2026-10-16: Switch bounce characterization, tuned debounce limit in EEPROM
+2026-10-16: Bounce bursts closed from ReadAll, no stamp wrap on long gaps
+2026-10-16: Capture re-armed by ReadAll after debounced release
+2026-10-16: Short driver description
 */
 
 /**** Hardware configuration ****
@@ -13,73 +22,130 @@ PD0 - MASTER_UP - Master switch input pull-up/down power
 PD1 - EXTKILL_UP - External kill switch pull-up/down power
 PD2 - MASTER - Master switch signal
 PD3 - EXTKILL - External kill signal
+
+PCINT18 (PD2), PCINT19 (PD3) - wake-up, kill capture, bounce stamps, PCINT2 vector
+*/
+
+/**** Description ****
+Inputs are bit-parallel, one lane per PORTD bit, debounced by vertical counter
+with separate assert/release limits. Capture input latches active edge in
+PCINT ISR after glitch confirmation, with 8us stamp, and is re-armed by ReadAll
+after debounced release. Characterized inputs measure bounce bursts, closed by
+ReadAll. Strobed inputs power pull-up only for the sample.
 */
 
 /**** Includes ****/
 #include <avr/io.h>
+#include <avr/interrupt.h>
+#include <util/atomic.h>
+#include <avr/eeprom.h>
+#include "systick_driver.h"
 #include "inputs_driver.h"
 
 /**** Private definitions ****/
-typedef struct inStateStruct {
-	uint8_t level;
-	uint8_t changed;
-	uint8_t blocked;
-	uint8_t dbnc_timer;
-}inStateDef;
+#define IN_DBNC_PLANES	7
+
+typedef struct inHwStruct {
+	uint8_t pin; //Signal pin mask, PORTD
+	uint8_t pull; //Pull supply pin mask, PORTD
+}inHwDef;
 
 /**** Private variables ****/
-static volatile inStateDef mstr;
-static volatile inCfgDef mstr_cfg;
+static const inHwDef hwTable[IN_COUNT] = {
+	{0x04, 0x01}, //IN_MASTER, PD2, PD0
+	{0x08, 0x02}  //IN_KILL, PD3, PD1
+};
+
+static volatile inCfgDef cfg[IN_COUNT];
+static uint8_t strobe_timer[IN_COUNT];
+static volatile uint16_t capt_stamp[IN_COUNT];
+
+//Bit-parallel state, lane is PORTD bit
+static volatile uint8_t used = 0; //Lanes of configured inputs
+static volatile uint8_t act_high = 0; //Lanes with active high level
+static volatile uint8_t level = 0; //Debounced pin level
+static volatile uint8_t sample = 0; //Last sampled pin level
+static volatile uint8_t changed = 0;
+static volatile uint8_t blocked = 0;
+static volatile uint8_t captured = 0;
+static volatile uint8_t integ = 0; //Lanes with integrating debounce
+static volatile uint8_t cnt[IN_DBNC_PLANES];
+static uint8_t lim_assert[IN_DBNC_PLANES];
+static uint8_t lim_release[IN_DBNC_PLANES];
 
-static volatile inStateDef kill;
-static volatile inCfgDef kill_cfg;
+static volatile uint8_t wake_mask = 0;
+static volatile uint8_t capt_mask = 0;
+
+static volatile uint8_t char_mask = 0;
+static volatile uint8_t char_last = 0;
+static volatile uint8_t char_open = 0; //Burst in progress, closed by ReadAll
+static volatile uint16_t char_first[IN_COUNT];
+static volatile uint16_t char_edge[IN_COUNT];
+static volatile uint16_t char_worst[IN_COUNT];
+static uint8_t EEMEM ee_limit[IN_COUNT] = {IN_LIMIT_NONE,IN_LIMIT_NONE};
 
 /**** Private function declarations ****/
+static void SetInactive(uint8_t idx);
 static void HAL_Init(void);
-static uint8_t HAL_ReadKill(void);
-static uint8_t HAL_ReadMaster(void);
-static void HAL_SetMasterPull(uint8_t side);
-static void HAL_SetKillPull(uint8_t side);
+static uint8_t HAL_ReadPins(void);
+static void HAL_SetPull(uint8_t idx, uint8_t side);
+static void HAL_UpdatePcint(void);
 
 /**** Public function definitions ****/
 /**
  * @brief Initializes driver
- * @param [in] pMstrCfg Master switch configuration
- * @param [in] pKillCfg Kill switch configuration
+ * @param [in] pCfg Input configuration table, IN_COUNT entries, index is channel-1
  */
-void INDRV_Init(inCfgDef* pMstrCfg,inCfgDef* pKillCfg)
+void INDRV_Init(const inCfgDef* pCfg)
 {
 	//Initialize hardware
 	HAL_Init();
 	
-	//Set config
-	mstr_cfg.act_level = pMstrCfg->act_level;
-	mstr_cfg.pull = pMstrCfg->pull;
-	mstr_cfg.dbnc_limit = pMstrCfg->dbnc_limit;
-	
-	kill_cfg.act_level = pKillCfg->act_level;
-	kill_cfg.pull = pKillCfg->pull;
-	kill_cfg.dbnc_limit = pKillCfg->dbnc_limit;
-	
-	//Set default values
-	if(mstr_cfg.act_level) mstr.level = 0; 
-	else mstr.level = 1;
+	used = 0;
+	act_high = 0;
+	integ = 0;
+	for(uint8_t p=0; p<IN_DBNC_PLANES; p++){cnt[p] = 0; lim_assert[p] = 0; lim_release[p] = 0;}
 	
-	mstr.changed = 0;
-	mstr.blocked = 0;
-	mstr.dbnc_timer = 0;
-	
-	//Set default values
-	if(kill_cfg.act_level) kill.level = 0; 
-	else kill.level = 1;
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		uint8_t pin = hwTable[i].pin;
+		
+		//Set config
+		cfg[i] = pCfg[i];
+		if(cfg[i].capture) cfg[i].strobe = 0;
+		if(cfg[i].assert_limit>((1<<IN_DBNC_PLANES)-2)) cfg[i].assert_limit = (1<<IN_DBNC_PLANES)-2;
+		if(cfg[i].release_limit>((1<<IN_DBNC_PLANES)-2)) cfg[i].release_limit = (1<<IN_DBNC_PLANES)-2;
+		
+		used |= pin;
+		if(cfg[i].act_level) act_high |= pin;
+		if(cfg[i].dbnc_mode==IN_DBNC_INTEGRATE) integ |= pin;
+		
+		//Level changes when counter exceeds limit, store limit+1 in planes
+		uint8_t la = cfg[i].assert_limit+1;
+		uint8_t lr = cfg[i].release_limit+1;
+		for(uint8_t p=0; p<IN_DBNC_PLANES; p++)
+		{
+			if(la&(1<<p)) lim_assert[p] |= pin;
+			if(lr&(1<<p)) lim_release[p] |= pin;
+		}
+		
+		//Set default values
+		SetInactive(i);
+		strobe_timer[i] = 0;
+		
+		//Apply pull-x config, strobed supplies are off between samples
+		if(cfg[i].strobe) HAL_SetPull(i,IN_PULL_NONE);
+		else HAL_SetPull(i,cfg[i].pull);
+	}
 	
-	kill.changed = 0;
-	kill.blocked = 0;
-	kill.dbnc_timer = 0;
+	changed = 0;
+	blocked = 0;
+	captured = 0;
 	
-	//Apply pull-x config
-	HAL_SetMasterPull(mstr_cfg.pull);
-	HAL_SetKillPull(kill_cfg.pull);
+	//Capture is armed by Wake
+	capt_mask = 0;
+	wake_mask = 0;
+	HAL_UpdatePcint();
 }
 
 /**
@@ -87,31 +153,103 @@ void INDRV_Init(inCfgDef* pMstrCfg,inCfgDef* pKillCfg)
  */
 void INDRV_ReadAll(void)
 {
-	uint8_t temp = 0;
+	uint8_t smpl = 0;
+	uint8_t settle = 0;
+	
+	//Close bounce bursts after quiet time, checked every call so stamps don't wrap
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		uint8_t pin = hwTable[i].pin;
+		if(!(char_open&pin)) continue;
+		
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			//Stamp taken with edges blocked, never older than last edge
+			uint16_t now = TICKDRV_GetStamp();
+			uint16_t quiet = now-char_edge[i];
+			uint16_t dur = now-char_first[i];
+			if((quiet>IN_CHAR_QUIET)||(dur>IN_CHAR_MAX_BURST)) char_open &= ~pin;
+		}
+	}
 	
-	//Master switch input
-	if(!mstr.blocked)
+	//Strobe pull-up supplies of inputs due for sample
+	for(uint8_t i=0; i<IN_COUNT; i++)
 	{
-		if(HAL_ReadMaster()) temp = 1;
-		else temp = 0;
+		uint8_t pin = hwTable[i].pin;
 		
-		if(mstr.level!=temp) mstr.dbnc_timer++;
-		else mstr.dbnc_timer = 0;
+		if((blocked&pin)||(char_mask&pin)||(!cfg[i].strobe)){smpl |= pin; continue;};
 		
-		if(mstr.dbnc_timer>mstr_cfg.dbnc_limit){mstr.level = temp; mstr.changed = 1;};
-	};	
-
-	//Kill switch input
-	if(!kill.blocked)
+		if(strobe_timer[i]) strobe_timer[i]--;
+		else
+		{
+			strobe_timer[i] = cfg[i].strobe-1;
+			HAL_SetPull(i,cfg[i].pull);
+			if(cfg[i].settle>settle) settle = cfg[i].settle;
+			smpl |= pin;
+		};
+	}
+	
+	if(settle) TICKDRV_DelayUs(settle);
+	
+	//One port read for all inputs, held sample on lanes not strobed now
+	uint8_t pins = HAL_ReadPins();
+	
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		uint8_t pin = hwTable[i].pin;
+		if((cfg[i].strobe)&&(smpl&pin)&&(!(char_mask&pin))) HAL_SetPull(i,IN_PULL_NONE);
+	}
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		if(HAL_ReadKill()) temp = 1;
-		else temp = 0;
+		sample = (sample&~smpl)|(pins&smpl);
 		
-		if(kill.level!=temp) kill.dbnc_timer++;
-		else kill.dbnc_timer = 0;
+		//Lanes differing from level count up, matching lanes are reset or count down
+		uint8_t en = used&~blocked;
+		uint8_t diff = (sample^level)&en;
+		uint8_t same = (~diff)&en;
+		uint8_t nz = 0;
+		for(uint8_t p=0; p<IN_DBNC_PLANES; p++) nz |= cnt[p];
 		
-		if(kill.dbnc_timer>kill_cfg.dbnc_limit){kill.level = temp; kill.changed = 1;};
-	};
+		uint8_t carry = diff;
+		uint8_t borrow = same&integ&nz;
+		uint8_t keep = diff|borrow;
+		
+		//Active lanes are released, others asserted
+		uint8_t act = (~(level^act_high))&en;
+		uint8_t eq = diff;
+		
+		for(uint8_t p=0; p<IN_DBNC_PLANES; p++)
+		{
+			uint8_t c = cnt[p]&keep;
+			uint8_t t = c&carry;
+			uint8_t b = (~c)&borrow;
+			c ^= carry|borrow;
+			carry = t;
+			borrow = b;
+			eq &= ~(c^((lim_release[p]&act)|(lim_assert[p]&~act)));
+			cnt[p] = c;
+		}
+		
+		//Lanes at limit take sampled level
+		level ^= eq;
+		changed |= eq;
+		for(uint8_t p=0; p<IN_DBNC_PLANES; p++) cnt[p] &= ~eq;
+	}
+	
+	//Re-arm capture of inputs released by debounce
+	uint8_t rearm = 0;
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		if(cfg[i].capture) rearm |= hwTable[i].pin;
+	}
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		rearm &= (level^act_high)&~blocked&~capt_mask;
+		capt_mask |= rearm;
+	}
+	if(rearm) HAL_UpdatePcint();
 }
 
 /**
@@ -120,36 +258,22 @@ void INDRV_ReadAll(void)
  */
 void INDRV_Sleep(uint8_t ch)
 {
-	switch(ch)
+	if((ch==0)||(ch>IN_COUNT)) return;
+	uint8_t i = ch-1;
+	uint8_t pin = hwTable[i].pin;
+	
+	//Set not-active level, reset values
+	SetInactive(i);
+	
+	//Disable capture and pull-x
+	capt_mask &= ~pin;
+	HAL_UpdatePcint();
+	HAL_SetPull(i,IN_PULL_NONE);
+	
+	//Set blocked flag
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		case IN_MASTER:
-			//Set not-active level
-			if(mstr_cfg.act_level) mstr.level = 0; 
-			else mstr.level = 1;
-			//Reset values
-			mstr.changed = 0;
-			mstr.dbnc_timer = 0;
-			//Disable pull-x
-			HAL_SetMasterPull(IN_PULL_NONE);
-			//Set blocked flag
-			mstr.blocked = 1;
-			break;
-		
-		case IN_KILL:
-			//Set not-active level
-			if(kill_cfg.act_level) kill.level = 0; 
-			else kill.level = 1;
-			//Reset values
-			kill.changed = 0;
-			kill.dbnc_timer = 0;
-			//Disable pull-x
-			HAL_SetKillPull(IN_PULL_NONE);
-			//Set blocked flag
-			kill.blocked = 1;
-			break;
-		
-		default:
-			break;
+		blocked |= pin;
 	}
 }
 
@@ -159,36 +283,116 @@ void INDRV_Sleep(uint8_t ch)
  */
 void INDRV_Wake(uint8_t ch)
 {
-	switch(ch)
+	if((ch==0)||(ch>IN_COUNT)) return;
+	uint8_t i = ch-1;
+	uint8_t pin = hwTable[i].pin;
+	
+	//Set not-active level, reset values
+	SetInactive(i);
+	strobe_timer[i] = 0;
+	
+	//Restore pull-x, strobed supply stays off until sample
+	if(!cfg[i].strobe) HAL_SetPull(i,cfg[i].pull);
+	
+	//Reset blocked flag
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		blocked &= ~pin;
+	}
+	
+	//Arm capture of active edge
+	if(cfg[i].capture){capt_mask |= pin; HAL_UpdatePcint();};
+}
+
+/**
+ * @brief Arm pin change wake-up on input channel
+ * @param [in] ch Input channel
+ * @return Armed [0-input level differs from debounced level, not armed,1-armed]
+ */
+uint8_t INDRV_ArmWakeup(uint8_t ch)
+{
+	if((ch==0)||(ch>IN_COUNT)) return 0;
+	uint8_t i = ch-1;
+	uint8_t pin = hwTable[i].pin;
+	
+	//Pin change needs continuous pull-up
+	if(cfg[i].strobe)
 	{
-		case IN_MASTER:
-			//Set not-active level
-			if(mstr_cfg.act_level) mstr.level = 0; 
-			else mstr.level = 1;
-			//Reset values
-			mstr.changed = 0;
-			mstr.dbnc_timer = 0;
-			//Restore pull-x
-			HAL_SetMasterPull(mstr_cfg.pull);
-			//Reset blocked flag
-			mstr.blocked = 0;
-			break;
-		
-		case IN_KILL:
-			///Set not-active level
-			if(kill_cfg.act_level) kill.level = 0; 
-			else kill.level = 1;
-			//Reset values
-			kill.changed = 0;
-			kill.dbnc_timer = 0;
-			//Restore pull-x
-			HAL_SetKillPull(kill_cfg.pull);
-			//Reset blocked flag
-			kill.blocked = 0;
-			break;
-		
-		default:
-			break;
+		HAL_SetPull(i,cfg[i].pull);
+		TICKDRV_DelayUs(cfg[i].settle);
+	};
+	
+	//Change already pending, it wouldn't cause an interrupt
+	if((HAL_ReadPins()^level)&pin) return 0;
+	
+	wake_mask |= pin;
+	char_open = 0; //System tick stops in power-down, next edge is a new burst
+	PCIFR = 0x04; //Clear pending PCINT2 flag
+	HAL_UpdatePcint();
+	
+	return 1;
+}
+
+/**
+ * @brief Disarm pin change wake-up of all input channels
+ */
+void INDRV_DisarmWakeup(void)
+{
+	wake_mask = 0;
+	HAL_UpdatePcint();
+	
+	//Back to strobed pull-up supplies
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		if((cfg[i].strobe)&&(!(blocked&hwTable[i].pin))) HAL_SetPull(i,IN_PULL_NONE);
+	}
+}
+
+/**
+ * @brief Enable bounce characterization of input channel
+ * @param [in] ch Input channel
+ * @param [in] en Enable [0-disable,1-enable, worst bounce is reset]
+ */
+void INDRV_SetCharacterize(uint8_t ch, uint8_t en)
+{
+	if((ch==0)||(ch>IN_COUNT)) return;
+	uint8_t i = ch-1;
+	uint8_t pin = hwTable[i].pin;
+	
+	if(en)
+	{
+		//Edges need continuous pull-up
+		HAL_SetPull(i,cfg[i].pull);
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			char_worst[i] = 0;
+			char_open &= ~pin;
+			char_last = (char_last&~pin)|(HAL_ReadPins()&pin);
+			char_mask |= pin;
+		}
+	}
+	else
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			char_mask &= ~pin;
+		}
+		if((cfg[i].strobe)||(blocked&pin)) HAL_SetPull(i,IN_PULL_NONE);
+	};
+	
+	HAL_UpdatePcint();
+}
+
+/**
+ * @brief Write tuned debounce limits of characterized inputs to EEPROM, blocking
+ */
+void INDRV_StoreTunedLimits(void)
+{
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		//No bounce seen yet, keep stored value
+		uint8_t l = INDRV_GetTunedLimit(i+1);
+		if(l!=IN_LIMIT_NONE) eeprom_update_byte(&ee_limit[i],l);
 	}
 }
 
@@ -199,19 +403,12 @@ void INDRV_Wake(uint8_t ch)
  */
 uint8_t INDRV_GetInput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case 1:
-			if((!mstr.blocked)&&(mstr.level==mstr_cfg.act_level)) return 1;
-			else return 0;;
-		
-		case 2:
-			if((!kill.blocked)&&(kill.level==kill_cfg.act_level)) return 1;
-			else return 0;
-		
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>IN_COUNT)) return 0;
+	uint8_t pin = hwTable[ch-1].pin;
+	
+	//Active when level matches active level
+	if((!(blocked&pin))&&(!((level^act_high)&pin))) return 1;
+	else return 0;
 }
 
 /**
@@ -221,42 +418,127 @@ uint8_t INDRV_GetInput(uint8_t ch)
  */
 uint8_t INDRV_GetInputChange(uint8_t ch)
 {
-	switch(ch)
-	{	
-		case 1:
-			return mstr.changed ;
-		
-		case 2:
-			return kill.changed;
-		
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>IN_COUNT)) return 0;
+	
+	if(changed&hwTable[ch-1].pin) return 1;
+	else return 0;
 }
 
-
 /**
  * @brief Reset input channel state change flag
  * @param [in] ch Input channel
  */
 void INDRV_ResetInputChange(uint8_t ch)
 {
-	switch(ch)
+	if((ch==0)||(ch>IN_COUNT)) return;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		case 1:
-			mstr.changed = 0;
-			break;
-		
-		case 2:
-			kill.changed = 0;
-			break;
-		
-		default:
-			break;
+		changed &= ~hwTable[ch-1].pin;
+	}
+}
+
+/**
+ * @brief Read pin change wake-up state
+ * @return Wake-up armed [0-disarmed by pin change or not armed,1-armed]
+ */
+uint8_t INDRV_GetWakeupArmed(void)
+{
+	if(wake_mask) return 1;
+	else return 0;
+}
+
+/**
+ * @brief Read and reset input channel capture
+ * @param [in] ch Input channel
+ * @param [out] pStamp Active edge time, TICKDRV_GetStamp units (8us)
+ * @return Capture flag [0-no capture,1-active edge captured since last call]
+ */
+uint8_t INDRV_GetCapture(uint8_t ch, uint16_t* pStamp)
+{
+	uint8_t ret_val = 0;
+	
+	if((ch==0)||(ch>IN_COUNT)) return 0;
+	uint8_t pin = hwTable[ch-1].pin;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(captured&pin) ret_val = 1;
+		*pStamp = capt_stamp[ch-1];
+		captured &= ~pin;
+	}
+	
+	return ret_val;
+}
+
+/**
+ * @brief Get worst bounce of input channel
+ * @param [in] ch Input channel
+ * @return Longest edge burst since characterization enable, 8us units
+ */
+uint16_t INDRV_GetBounce(uint8_t ch)
+{
+	uint16_t worst = 0;
+	
+	if((ch==0)||(ch>IN_COUNT)) return 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		worst = char_worst[ch-1];
 	}
+	
+	return worst;
+}
+
+/**
+ * @brief Get debounce limit tuned from worst bounce
+ * @param [in] ch Input channel
+ * @return Debounce limit in ReadAll calls (1ms), IN_LIMIT_NONE if no bounce measured
+ */
+uint8_t INDRV_GetTunedLimit(uint8_t ch)
+{
+	uint16_t worst = INDRV_GetBounce(ch);
+	
+	if(!worst) return IN_LIMIT_NONE;
+	
+	//8us units to ms rounded up, one tick margin
+	uint16_t l = (uint16_t)((((uint32_t)worst*8)+999)/1000)+1;
+	if(l>((1<<IN_DBNC_PLANES)-2)) l = (1<<IN_DBNC_PLANES)-2;
+	return (uint8_t)l;
+}
+
+/**
+ * @brief Get tuned debounce limit stored in EEPROM
+ * @param [in] ch Input channel
+ * @return Debounce limit, IN_LIMIT_NONE if not stored
+ */
+uint8_t INDRV_GetStoredLimit(uint8_t ch)
+{
+	if((ch==0)||(ch>IN_COUNT)) return IN_LIMIT_NONE;
+	
+	return eeprom_read_byte(&ee_limit[ch-1]);
 }
 
 /**** Private function definitions ****/
+/**
+ * @brief Set input lane to not-active level and reset its state
+ * @param [in] idx Input table index
+ */
+static void SetInactive(uint8_t idx)
+{
+	uint8_t pin = hwTable[idx].pin;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if(cfg[idx].act_level) level &= ~pin;
+		else level |= pin;
+		sample = (sample&~pin)|(level&pin);
+		changed &= ~pin;
+		captured &= ~pin;
+		for(uint8_t p=0; p<IN_DBNC_PLANES; p++) cnt[p] &= ~pin;
+	}
+}
+
 /***** HARDWARE ABSTRACTION LAYER *****/
 
 /**
@@ -264,64 +546,125 @@ void INDRV_ResetInputChange(uint8_t ch)
  */
 void HAL_Init(void)
 {
+	uint8_t pins = 0;
+	uint8_t pulls = 0;
+	
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		pins |= hwTable[i].pin;
+		pulls |= hwTable[i].pull;
+	}
+	
 	//Inputs configuration
-	DDRD &= ~0x0C; //Set as inputs
-	PORTD &= ~0x0C; //Disable MCU pull-up
+	DDRD &= ~pins; //Set as inputs
+	PORTD &= ~pins; //Disable MCU pull-up
 	
 	//Pull-x outputs configuration
-	DDRD |= 0x03; //Set as outputs
-	PORTD &= ~0x03; //Set low
-}
-
-/**
- * @brief Reads kill switch input level
- * @return level of kill input
- */
-uint8_t HAL_ReadKill(void)
-{
-	if(PIND&0x08) return 1;
-	else return 0;
+	DDRD |= pulls; //Set as outputs
+	PORTD &= ~pulls; //Set low
 }
 
 /**
- * @brief Reads master switch input level
- * @return level of master input
+ * @brief Reads all input pins
+ * @return PORTD pin levels
  */
-uint8_t HAL_ReadMaster(void)
+uint8_t HAL_ReadPins(void)
 {
-	if(PIND&0x04) return 1;
-	else return 0;
+	return PIND;
 }
 
 /**
- * @brief Master input pull-x control
+ * @brief Input pull-x control
+ * @param [in] idx Input table index
  * @param [in] side Pull-x side
  */
-void HAL_SetMasterPull(uint8_t side)
+void HAL_SetPull(uint8_t idx, uint8_t side)
 {
 	if(side==IN_PULL_UP)
 	{
-		PORTD |= 0x01; //Set pull-x high
-
+		PORTD |= hwTable[idx].pull; //Set high
 	}
 	else
 	{
-		PORTD &= ~0x01; //Set low
+		PORTD &= ~hwTable[idx].pull; //Set low
 	}
 }
 
 /**
- * @brief Kill input pull-x control
- * @param [in] side Pull-x side
+ * @brief Apply wake-up and capture pin change masks
  */
-void HAL_SetKillPull(uint8_t side)
+void HAL_UpdatePcint(void)
 {
-	if(side==IN_PULL_UP)
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		PORTD |= 0x02; //Set high
+		PCMSK2 = (PCMSK2&~used)|wake_mask|capt_mask|char_mask;
+		if(PCMSK2&used) PCICR |= 0x04; //PCINT2 enable
+		else PCICR &= ~0x04; //PCINT2 disable
 	}
-	else
+}
+
+/**** Interrupt handlers ****/
+/**
+ * @brief Pin change on input pins, wake-up and active edge capture
+ */
+ISR(PCINT2_vect)
+{
+	uint16_t stamp = TICKDRV_GetStamp();
+	
+	uint8_t pins = HAL_ReadPins();
+	
+	//Wake-up is one-shot, inputs are debounced by ReadAll after wake-up
+	wake_mask = 0;
+	
+	//Bounce characterization, stamp every edge
+	uint8_t chg = (pins^char_last)&char_mask;
+	char_last = pins;
+	for(uint8_t i=0; i<IN_COUNT; i++)
 	{
-		PORTD &= ~0x02; //Set low
+		if(!(chg&hwTable[i].pin)) continue;
+		
+		//Edge after burst was closed by ReadAll starts new burst
+		if(!(char_open&hwTable[i].pin))
+		{
+			char_first[i] = stamp;
+			char_open |= hwTable[i].pin;
+		};
+		char_edge[i] = stamp;
+		
+		uint16_t dur = stamp-char_first[i];
+		if(dur>char_worst[i]) char_worst[i] = dur;
+	}
+	
+	//Active edges of capture inputs
+	uint8_t edge = (~(pins^act_high))&capt_mask;
+	uint8_t armed = edge;
+	
+	//Mask own pins while confirming, no re-entry
+	capt_mask &= ~edge;
+	HAL_UpdatePcint();
+	if(!edge) return;
+	
+	//Glitch confirmation, other interrupts are allowed
+	sei();
+	for(uint8_t i=0; i<IN_CAPT_CONFIRM_CNT; i++)
+	{
+		TICKDRV_DelayUs(IN_CAPT_CONFIRM_US);
+		edge &= ~(HAL_ReadPins()^act_high);
+	}
+	cli();
+	
+	//Latch confirmed edges without debounce
+	level = (level&~edge)|(act_high&edge);
+	sample = (sample&~edge)|(act_high&edge);
+	changed |= edge;
+	captured |= edge;
+	for(uint8_t p=0; p<IN_DBNC_PLANES; p++) cnt[p] &= ~edge;
+	for(uint8_t i=0; i<IN_COUNT; i++)
+	{
+		if(edge&hwTable[i].pin) capt_stamp[i] = stamp;
 	}
-}
\ No newline at end of file
+	
+	//Glitch is re-armed now, latched input by ReadAll after release
+	capt_mask |= armed&~edge&~blocked;
+	HAL_UpdatePcint();
+}
@@ -6,6 +6,13 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Pin change wake-up from power-down
+2026-10-16: Strobed pull-up supplies
+2026-10-16: Pin change kill capture with timestamp and glitch confirmation
+2026-10-16: Input descriptor table, bit-parallel vertical counter debouncer
+2026-10-16: Separate assert/release limits, integrating debounce mode
+2026-10-16: Switch bounce characterization, tuned debounce limit in EEPROM
+2026-10-16: Longest bounce burst limit
 */
 
 #ifndef IN_DRIVER
@@ -16,12 +23,18 @@ Revision history:
 /**** Public definitions ****/
 typedef struct inCfgStruct {
 	uint8_t act_level;
-	uint8_t dbnc_limit;
+	uint8_t assert_limit; //Debounce to active level [0 to 126]
+	uint8_t release_limit; //Debounce to not-active level [0 to 126]
+	uint8_t dbnc_mode; //IN_DBNC_RESET or IN_DBNC_INTEGRATE
 	uint8_t pull;
+	uint8_t strobe; //Sample every N ReadAll calls with pull-up strobe, 0-pull-up always on
+	uint8_t settle; //Pull-up settle time before sample, us
+	uint8_t capture; //Pin change capture of active edge, latches level immediately
 }inCfgDef;
 
 #define IN_MASTER	1
 #define IN_KILL		2
+#define IN_COUNT	2
 
 #define IN_PULL_NONE	0
 #define IN_PULL_DOWN	1
@@ -30,11 +43,25 @@ typedef struct inCfgStruct {
 #define IN_ACT_LOW	0
 #define IN_ACT_HIGH	1
 
+#define IN_DBNC_RESET		0	//Counter is reset by matching sample
+#define IN_DBNC_INTEGRATE	1	//Up/down counter, matching sample counts down
+
+#define IN_CAPT_CONFIRM_CNT	4	//Samples input has to stay active after edge
+#define IN_CAPT_CONFIRM_US	8	//Interval of confirmation samples
+
+#define IN_CHAR_QUIET		6250	//No edges for 50ms ends bounce burst, 8us units
+#define IN_CHAR_MAX_BURST	31250	//Longer burst is split, 250ms, 8us units
+#define IN_LIMIT_NONE		0xFF	//No tuned limit stored
+
 /**** Public function declarations ****/
 //Control functions
-void INDRV_Init(inCfgDef* pMstrCfg,inCfgDef* pKillCfg);
+void INDRV_Init(const inCfgDef* pCfg);
 void INDRV_Sleep(uint8_t ch);
 void INDRV_Wake(uint8_t ch);
+uint8_t INDRV_ArmWakeup(uint8_t ch);
+void INDRV_DisarmWakeup(void);
+void INDRV_SetCharacterize(uint8_t ch, uint8_t en);
+void INDRV_StoreTunedLimits(void);
 
 //Interrupt and loop functions
 void INDRV_ReadAll(void);
@@ -43,5 +70,10 @@ void INDRV_ReadAll(void);
 uint8_t INDRV_GetInput(uint8_t ch);
 uint8_t INDRV_GetInputChange(uint8_t ch);
 void INDRV_ResetInputChange(uint8_t ch);
+uint8_t INDRV_GetWakeupArmed(void);
+uint8_t INDRV_GetCapture(uint8_t ch, uint16_t* pStamp);
+uint16_t INDRV_GetBounce(uint8_t ch);
+uint8_t INDRV_GetTunedLimit(uint8_t ch);
+uint8_t INDRV_GetStoredLimit(uint8_t ch);
 
 #endif
\ No newline at end of file
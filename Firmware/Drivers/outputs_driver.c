@@ -6,6 +6,21 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Protection limits as parameter, fast 8bit ADC protection path
+2026-10-16: Protection in calibrated ADC counts
+2026-10-16: Channel descriptor table, single protection engine for all channels
+2026-10-16: Precomputed level patterns, single PORTB store per logic update
+2026-10-16: Relay economizer, Timer1 PWM hold on isolator low side
+2026-10-16: I2t over-current protection instead of linear drop counter
+2026-10-16: Predictive trip on MOSFET drop slope
+2026-10-16: Instant trip from ADC ISR window, forced HiZ
+2026-10-16: Analog comparator short detector, forced HiZ
+2026-10-16: Stale output samples skipped by drop protection
+2026-10-16: No drop protection in PWM hold, output plausibility bound only
+2026-10-16: I2t time constant set for switch-on inrush
+2026-10-16: Instant trip confirmed by back-to-back re-conversion
+2026-10-16: PWM hold output sampled in on-time, full drop protection in hold
+2026-10-16: Short driver description
 */
 
 /**** Hardware configuration ****
@@ -15,8 +30,22 @@ PB6 - IGNC_P - Ignition control output, high side control, active high
 PB7 - ISOL_P - Isolator control output, high side control, active high
 */
 
+/**** Channel table ****
+Every output channel is one chTable entry, index ch-1. Logic writes PORTB for
+all channels with one store, break-before-make on direction change. Relay
+economizer drives low side for pullin_time, then holds coil with Timer1 9bit
+PWM on OC1A (PB1), output is sampled in on-time. Protection runs I2t and slope
+on MOSFET drop of fresh output samples. Instant trip (ADC window) and optional
+comparator force channel HiZ from ISR, protection turns it into a fault.
+*/
+
 /**** Includes ****/
 #include <avr/io.h>
+#include <util/atomic.h>
+#include "adc_driver.h"
+#include "i2t_driver.h"
+#include "slope_driver.h"
+#include "comp_driver.h"
 #include "outputs_driver.h"
 
 /**** Private definitions ****/
@@ -28,7 +57,9 @@ typedef struct ProtectionStruct {
 	uint8_t ocp_warning;
 	uint8_t ovp_warning;
 	uint8_t uvp_warning;
-	uint8_t ocp_counter;
+	i2tDef ocp_i2t;
+	slopeDef ocp_slope;
+	uint8_t slope_rst;
 	uint16_t cooldown_timer;
 	uint8_t ext_fault;
 	uint8_t fault;
@@ -39,83 +70,146 @@ typedef struct ProtectionStruct {
 	uint16_t retry_timer;
 }ProtectionDef;
 
+typedef struct ProtLimitsStruct {
+	uint16_t ovp;
+	uint16_t uvp;
+	uint16_t qdrop;
+}ProtLimitsDef;
+
+typedef struct ProtParamStruct {
+	ProtLimitsDef lim;
+	ProtLimitsDef lim_fast;
+	uint8_t ocp_lim;	//I2t drop units
+	uint8_t ocp_tau;
+	uint8_t ocp_deadtime;
+	uint16_t cooldown_time;
+	uint16_t retry_timeout;
+	uint16_t slope_lim;	//I2t drop units
+	int16_t slope_min;
+	uint8_t slope_horizon;
+	uint16_t inst_lim;	//Calibrated ADC counts
+}ProtParamDef;
+
 typedef struct SatusStruct {
 	uint8_t hw;
 	uint8_t target;
 	uint8_t real;
 	uint8_t en;
+	uint8_t hold;
+	uint16_t pullin_timer;
 }SatusDef;
 
-/**** Private variables ****/
-static volatile SatusDef igncState;
-static volatile outConfigDef igncCfg;
-static volatile ProtectionDef igncProt;
+typedef struct ChannelStruct {
+	uint8_t pin_hs;
+	uint8_t pin_ls;
+	uint8_t pwm_ls;		//Low side is Timer1 OC1A
+	uint8_t adc_out;	//Output voltage ADC channel
+	const ProtParamDef* pPar;
+	uint8_t lvl[2];		//HW level for off/on state
+	uint8_t pat[3];		//PORTB pattern for HiZ/low/high level
+	outConfigDef cfg;
+	SatusDef state;
+	ProtectionDef prot;
+}ChannelDef;
 
-static volatile SatusDef isolState;
-static volatile outConfigDef isolCfg;
-static volatile ProtectionDef isolProt;
+/**** Private variables ****/
+//Limits in calibrated ADC counts and in fast 8bit ADC values
+static const ProtParamDef isolPar = {
+	{ADC_MV_TO_COUNTS(ISOL_OVERVOLATGE_LIMIT), ADC_MV_TO_COUNTS(ISOL_UNDERVOLATGE_LIMIT), ADC_MV_TO_COUNTS(ISOL_QDROP_LIMIT)},
+	{ADC_MV_TO_FAST(ISOL_OVERVOLATGE_LIMIT), ADC_MV_TO_FAST(ISOL_UNDERVOLATGE_LIMIT), ADC_MV_TO_FAST(ISOL_QDROP_LIMIT)},
+	I2T_MV_TO_DROP(ISOL_QDROP_LIMIT), ISOL_OCP_TAU, ISOL_OCP_DEAD_TIME, ISOL_FAULT_COOLDOWN_TIME, ISOL_FAULT_RETRY_TIMEOUT,
+	I2T_MV_TO_DROP(ISOL_QDROP_HARD_LIMIT), SLP_MV_TO_SLOPE(ISOL_QDROP_SLOPE), ISOL_QDROP_HORIZON,
+	ADC_MV_TO_COUNTS(ISOL_QDROP_INSTANT)
+};
+
+static const ProtParamDef igncPar = {
+	{ADC_MV_TO_COUNTS(IGNC_OVERVOLATGE_LIMIT), ADC_MV_TO_COUNTS(IGNC_UNDERVOLATGE_LIMIT), ADC_MV_TO_COUNTS(IGNC_QDROP_LIMIT)},
+	{ADC_MV_TO_FAST(IGNC_OVERVOLATGE_LIMIT), ADC_MV_TO_FAST(IGNC_UNDERVOLATGE_LIMIT), ADC_MV_TO_FAST(IGNC_QDROP_LIMIT)},
+	I2T_MV_TO_DROP(IGNC_QDROP_LIMIT), IGNC_OCP_TAU, IGNC_OCP_DEAD_TIME, IGNC_FAULT_COOLDOWN_TIME, IGNC_FAULT_RETRY_TIMEOUT,
+	I2T_MV_TO_DROP(IGNC_QDROP_HARD_LIMIT), SLP_MV_TO_SLOPE(IGNC_QDROP_SLOPE), IGNC_QDROP_HORIZON,
+	ADC_MV_TO_COUNTS(IGNC_QDROP_INSTANT)
+};
+
+//Channel table, state written from main loop only, ADC and comparator ISRs read pins and adc_out
+static ChannelDef chTable[OUT_COUNT] = {
+	{.pin_hs = 0x80, .pin_ls = 0x02, .pwm_ls = 1, .adc_out = ADC_ISOL, .pPar = &isolPar}, //OUT_ISOL, PB7 high side, PB1 low side
+	{.pin_hs = 0x40, .pin_ls = 0x01, .pwm_ls = 0, .adc_out = ADC_IGNC, .pPar = &igncPar}  //OUT_IGNC, PB6 high side, PB0 low side
+};
+
+static uint8_t out_pins = 0;
+static volatile uint8_t trip_pins = 0; //Forced HiZ by instant trip
+static uint8_t comp_idx = OUT_COUNT; //Comparator channel, OUT_COUNT-none
 
 /**** Private function declarations ****/
-static uint8_t ProcessIgnitionProtection(uint16_t volt_pwrsrc, uint16_t volt_out);
-static uint8_t ProcessIsolatorProtection(uint16_t volt_pwrsrc, uint16_t volt_out);
-static uint8_t StateToHWLevel(outConfigDef cfg, uint8_t state);
+static uint8_t ProcessChannelProtection(ChannelDef* pCh, uint16_t volt_pwrsrc, uint16_t volt_out, const ProtLimitsDef* pLim, uint8_t fast, uint8_t fresh);
+static uint8_t StateToHWLevel(const outConfigDef* pCfg, uint8_t state);
 static void HAL_Init(void);
-static void HAL_SetIgnition(uint8_t level);
-static void HAL_SetIsolator(uint8_t level);
+static void HAL_WritePins(uint8_t pins, uint8_t bbm);
+static void HAL_StartPwm(uint8_t duty);
+static void HAL_StopPwm(void);
+static void HAL_InstantTrip(uint8_t adc_ch);
+static void HAL_CompTrip(void);
+static void HAL_ForceHiZ(ChannelDef* pCh);
 
 /**** Public function definitions ****/
 /**
  * @brief Initializes driver
- * @param [in] pIsolCfg Isolator output configuration
- * @param [in] pIgncCfg Ignition output configuration
+ * @param [in] pCfg Output configuration table, OUT_COUNT entries, index ch-1
  */
-void OUTDRV_Init(outConfigDef* pIsolCfg, outConfigDef* pIgncCfg)
+void OUTDRV_Init(const outConfigDef* pCfg)
 {
 	HAL_Init();
 	
-	//Reset ignition variables
-	igncState.target = 0;
-	igncState.real = 0;
-	igncState.en = 0;
-	
-	igncCfg.type = pIgncCfg->type;
-	igncCfg.inv = pIgncCfg->inv;
-	igncCfg.ext_fault_en = pIgncCfg->ext_fault_en;
-	
-	igncProt.ocp_warning = 0;
-	igncProt.ovp_warning = 0;
-	igncProt.uvp_warning = 0;
-	igncProt.ocp_counter = 0;
-	igncProt.cooldown_timer = 0;
-	igncProt.ext_fault = 0;
-	igncProt.fault = 0;
-	igncProt.delay_exec = 0;
-	igncProt.ocp_deadtime = 0;
-	igncProt.retry_flag = 0;
-	igncProt.fault_cnt = 0;
-	igncProt.retry_timer = 0;
+	CMPDRV_Disarm();
+	comp_idx = OUT_COUNT;
 	
-	//Reset isolator variables
-	isolState.target = 0;
-	isolState.real = 0;
-	isolState.en = 0;
-	
-	isolCfg.type = pIsolCfg->type;
-	isolCfg.inv = pIsolCfg->inv;
-	isolCfg.ext_fault_en = pIsolCfg->ext_fault_en;
+	for(uint8_t i=0; i<OUT_COUNT; i++)
+	{
+		ChannelDef* pCh = &chTable[i];
+		
+		pCh->cfg = pCfg[i];
+		if(!pCh->pwm_ls) pCh->cfg.pullin_time = 0;
+		//On-time has to cover ADC sample delay
+		if((pCh->cfg.pullin_time)&&(pCh->cfg.hold_duty<OUT_HOLD_DUTY_MIN)) pCh->cfg.hold_duty = OUT_HOLD_DUTY_MIN;
+		
+		//Only one comparator
+		if((pCh->cfg.comp_trip)&&(comp_idx==OUT_COUNT)) comp_idx = i;
+		else pCh->cfg.comp_trip = 0;
+		
+		//Resolve output type once
+		pCh->lvl[0] = StateToHWLevel(&pCh->cfg,0);
+		pCh->lvl[1] = StateToHWLevel(&pCh->cfg,1);
+		pCh->pat[HWOUT_HIZ] = 0;
+		pCh->pat[HWOUT_LOW] = pCh->pin_ls;
+		pCh->pat[HWOUT_HIGH] = pCh->pin_hs;
+		
+		pCh->state.target = 0;
+		pCh->state.real = 0;
+		pCh->state.en = 0;
+		pCh->state.hold = 0;
+		pCh->state.pullin_timer = 0;
+		
+		pCh->prot.ocp_warning = 0;
+		pCh->prot.ovp_warning = 0;
+		pCh->prot.uvp_warning = 0;
+		I2TDRV_Init(&pCh->prot.ocp_i2t,pCh->pPar->ocp_lim,pCh->pPar->ocp_tau);
+		SLPDRV_Init(&pCh->prot.ocp_slope,pCh->pPar->slope_lim,pCh->pPar->slope_min,pCh->pPar->slope_horizon);
+		pCh->prot.slope_rst = 1;
+		pCh->prot.cooldown_timer = 0;
+		pCh->prot.ext_fault = 0;
+		pCh->prot.fault = 0;
+		pCh->prot.delay_exec = 0;
+		pCh->prot.ocp_deadtime = 0;
+		pCh->prot.retry_flag = 0;
+		pCh->prot.fault_cnt = 0;
+		pCh->prot.retry_timer = 0;
+		
+		ADCDRV_SetWindow(pCh->adc_out,ADC_WIN_LOW_OFF,ADC_WIN_HIGH_OFF);
+	}
 	
-	isolProt.ocp_warning = 0;
-	isolProt.ovp_warning = 0;
-	isolProt.uvp_warning = 0;
-	isolProt.ocp_counter = 0;
-	isolProt.cooldown_timer = 0;
-	isolProt.ext_fault = 0;
-	isolProt.fault = 0;
-	isolProt.delay_exec = 0;
-	isolProt.ocp_deadtime = 0;
-	isolProt.retry_flag = 0;
-	isolProt.fault_cnt = 0;
-	isolProt.retry_timer = 0;
+	trip_pins = 0;
+	ADCDRV_SetWindowHandler(HAL_InstantTrip);
+	CMPDRV_SetHandler(HAL_CompTrip);
 }
 
 /**
@@ -124,19 +218,8 @@ void OUTDRV_Init(outConfigDef* pIsolCfg, outConfigDef* pIgncCfg)
  */
 void OUTDRV_SetOutput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolState.target = 1;
-			break;
-			
-		case OUT_IGNC:
-			igncState.target = 1;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].state.target = 1;
 }
 
 /**
@@ -145,19 +228,8 @@ void OUTDRV_SetOutput(uint8_t ch)
  */
 void OUTDRV_ResetOutput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolState.target = 0;
-			break;
-			
-		case OUT_IGNC:
-			igncState.target = 0;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].state.target = 0;
 }
 
 /**
@@ -166,19 +238,8 @@ void OUTDRV_ResetOutput(uint8_t ch)
  */
 void OUTDRV_EnableOutput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolState.en = 1;
-			break;
-			
-		case OUT_IGNC:
-			igncState.en = 1;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].state.en = 1;
 }
 
 /**
@@ -187,19 +248,8 @@ void OUTDRV_EnableOutput(uint8_t ch)
  */
 void OUTDRV_DisableOutput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolState.en = 0;
-			break;
-			
-		case OUT_IGNC:
-			igncState.en = 0;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].state.en = 0;
 }
 
 /**
@@ -209,18 +259,8 @@ void OUTDRV_DisableOutput(uint8_t ch)
  */
 uint8_t OUTDRV_GetRealOutput(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			return isolState.real;
-			break;
-			
-		case OUT_IGNC:
-			return igncState.real;
-			
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return 0;
+	return chTable[ch-1].state.real;
 }
 
 /**
@@ -228,52 +268,121 @@ uint8_t OUTDRV_GetRealOutput(uint8_t ch)
  */
 void OUTDRV_ProcessLogic(void)
 {
-	if(igncProt.delay_exec)
-	{
-		igncProt.delay_exec--;
-	}
-	else if((igncProt.fault)||(igncProt.ext_fault)||(igncState.en==0))
-	{
-		//Disable output
-		HAL_SetIgnition(HWOUT_HIZ);
-		igncState.real = 0;
-	}
-	else
-	{
-		//Set intended output
-		HAL_SetIgnition(StateToHWLevel(igncCfg,igncState.target));
-		igncState.real = igncState.target;
-	}
+	uint8_t pins = 0;
+	uint8_t bbm = 0;
 	
-	if(isolProt.delay_exec)
-	{
-		isolProt.delay_exec--;
-	}
-	else if((isolProt.fault)||(isolProt.ext_fault)||(isolState.en==0))
+	for(uint8_t i=0; i<OUT_COUNT; i++)
 	{
-		//Disable output
-		HAL_SetIsolator(HWOUT_HIZ);
-		isolState.real = 0;
+		ChannelDef* pCh = &chTable[i];
+		uint8_t level = pCh->state.hw;
+		
+		if(pCh->prot.delay_exec)
+		{
+			pCh->prot.delay_exec--;
+		}
+		else if((pCh->prot.fault)||(pCh->prot.ext_fault)||(pCh->state.en==0))
+		{
+			//Disable output
+			level = HWOUT_HIZ;
+			pCh->state.real = 0;
+		}
+		else
+		{
+			//Set intended output
+			level = pCh->lvl[pCh->state.target];
+			pCh->state.real = pCh->state.target;
+		}
+		
+		if(level!=pCh->state.hw)
+		{
+			pCh->prot.ocp_deadtime = pCh->pPar->ocp_deadtime;
+			pCh->prot.slope_rst = 1;
+			ADCDRV_SetWindow(pCh->adc_out,ADC_WIN_LOW_OFF,ADC_WIN_HIGH_OFF);
+			if(pCh->cfg.comp_trip) CMPDRV_Disarm();
+			
+			//PWM overrides port pin, stop before new level is written
+			if(pCh->state.hold)
+			{
+				ADCDRV_SetSync(ADC_SYNC_NONE);
+				HAL_StopPwm();
+				pCh->state.hold = 0;
+			};
+			
+			//Pull-in starts with full drive
+			if(level==HWOUT_LOW) pCh->state.pullin_timer = pCh->cfg.pullin_time;
+			
+			//Direction change, other side must be off first
+			if((level!=HWOUT_HIZ)&&(pCh->state.hw!=HWOUT_HIZ)) bbm |= pCh->pin_hs|pCh->pin_ls;
+			pCh->state.hw = level;
+		}
+		else if(pCh->state.pullin_timer)
+		{
+			//Pull-in done, hold by PWM
+			pCh->state.pullin_timer--;
+			if(!pCh->state.pullin_timer)
+			{
+				ADCDRV_SetWindow(pCh->adc_out,ADC_WIN_LOW_OFF,ADC_WIN_HIGH_OFF);
+				if(pCh->cfg.comp_trip) CMPDRV_Disarm();
+				HAL_StartPwm(pCh->cfg.hold_duty);
+				ADCDRV_SetSync(pCh->adc_out);
+				pCh->state.hold = 1;
+				pCh->prot.ocp_deadtime = pCh->pPar->ocp_deadtime;
+				pCh->prot.slope_rst = 1;
+			};
+		};
+		
+		//Instant trip is released when channel is HiZ by itself
+		if(level==HWOUT_HIZ)
+		{
+			ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+			{
+				trip_pins &= ~(pCh->pin_hs|pCh->pin_ls);
+			}
+		};
+		
+		pins |= pCh->pat[level];
 	}
-	else
+	
+	HAL_WritePins(pins,bbm);
+}
+
+/**
+ * @brief Output protection processing
+ * @param [in] u_bat Battery voltage, calibrated ADC counts
+ * @param [in] u_isol Isolator control output voltage, calibrated ADC counts
+ * @param [in] u_alt Alternator voltage, calibrated ADC counts
+ * @param [in] u_ignc Ignition control output voltage, calibrated ADC counts
+ * @param [in] fresh Channels with output sampled in last scan, OUT_FRESH(ch) bits
+ */
+void OUTDRV_ProcessProtection(uint16_t u_bat, uint16_t u_isol, uint16_t u_alt, uint16_t u_ignc, uint8_t fresh)
+{
+	//Power source and output voltage per channel, table order
+	const uint16_t src[OUT_COUNT] = {u_bat, u_alt};
+	const uint16_t out[OUT_COUNT] = {u_isol, u_ignc};
+	
+	for(uint8_t i=0; i<OUT_COUNT; i++)
 	{
-		//Set intended output
-		HAL_SetIsolator(StateToHWLevel(isolCfg,isolState.target));
-		isolState.real = isolState.target;
+		ProcessChannelProtection(&chTable[i],src[i],out[i],&chTable[i].pPar->lim,0,fresh&(1<<i));
 	}
 }
 
 /**
- * @brief Output protection processing
- * @param [in] u_bat Battery voltage in mV
- * @param [in] u_isol Isolator control output voltage in mV
- * @param [in] u_alt Alternator voltage in mV
- * @param [in] u_ignc Ignition control output voltage in mV
+ * @brief Output protection processing from fast 8bit ADC values
+ * @param [in] c_bat Battery voltage, 8bit ADC value
+ * @param [in] c_isol Isolator control output voltage, 8bit ADC value
+ * @param [in] c_alt Alternator voltage, 8bit ADC value
+ * @param [in] c_ignc Ignition control output voltage, 8bit ADC value
+ * @param [in] fresh Channels with output sampled in last scan, OUT_FRESH(ch) bits
  */
-void OUTDRV_ProcessProtection(uint16_t u_bat, uint16_t u_isol, uint16_t u_alt, uint16_t u_ignc)
+void OUTDRV_ProcessFastProtection(uint8_t c_bat, uint8_t c_isol, uint8_t c_alt, uint8_t c_ignc, uint8_t fresh)
 {
-	ProcessIsolatorProtection(u_bat,u_isol);
-	ProcessIgnitionProtection(u_alt,u_ignc);
+	const uint8_t src[OUT_COUNT] = {c_bat, c_alt};
+	const uint8_t out[OUT_COUNT] = {c_isol, c_ignc};
+	
+	for(uint8_t i=0; i<OUT_COUNT; i++)
+	{
+		ProcessChannelProtection(&chTable[i],src[i],out[i],&chTable[i].pPar->lim_fast,1,fresh&(1<<i));
+	}
 }
 
 /**
@@ -283,19 +392,12 @@ void OUTDRV_ProcessProtection(uint16_t u_bat, uint16_t u_isol, uint16_t u_alt, u
  */
 uint8_t OUTDRV_GetFault(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			if((isolProt.fault)||(isolProt.ext_fault)) return 1;
-			else return 0;
-			
-		case OUT_IGNC:
-			if((igncProt.fault)||(igncProt.ext_fault)) return 1;
-			else return 0;
-			
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return 0;
+	
+	const ChannelDef* pCh = &chTable[ch-1];
+	if((pCh->prot.fault)||(pCh->prot.ext_fault)) return 1;
+	else if(trip_pins&(pCh->pin_hs|pCh->pin_ls)) return 1; //Forced HiZ, not picked up yet
+	else return 0;
 }
 
 /**
@@ -305,19 +407,10 @@ uint8_t OUTDRV_GetFault(uint8_t ch)
  */
 uint8_t OUTDRV_GetRetryFlag(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			if(isolProt.retry_flag) return 1;
-			else return 0;
-			
-		case OUT_IGNC:
-			if(igncProt.retry_flag) return 1;
-			else return 0;
-			
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return 0;
+	
+	if(chTable[ch-1].prot.retry_flag) return 1;
+	else return 0;
 }
 
 /**
@@ -326,19 +419,8 @@ uint8_t OUTDRV_GetRetryFlag(uint8_t ch)
  */
 void OUTDRV_ResetRetryFlag(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolProt.retry_flag = 0;
-			break;
-			
-		case OUT_IGNC:
-			igncProt.retry_flag = 0;
-			break;
-			
-		default:
-			break;;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].prot.retry_flag = 0;
 }
 
 /**
@@ -348,17 +430,8 @@ void OUTDRV_ResetRetryFlag(uint8_t ch)
  */
 uint8_t OUTDRV_GetFaultCount(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			return isolProt.fault_cnt;
-			
-		case OUT_IGNC:
-			return igncProt.fault_cnt;
-			
-		default:
-			return 0;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return 0;
+	return chTable[ch-1].prot.fault_cnt;
 }
 
 /**
@@ -367,21 +440,11 @@ uint8_t OUTDRV_GetFaultCount(uint8_t ch)
  */
 void OUTDRV_SetExtFault(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			if(isolCfg.ext_fault_en) isolProt.ext_fault = 1; 
-			else isolProt.ext_fault = 0;
-			break;
-			
-		case OUT_IGNC:
-			if(igncCfg.ext_fault_en) igncProt.ext_fault = 1; 
-			else igncProt.ext_fault = 0;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	
+	ChannelDef* pCh = &chTable[ch-1];
+	if(pCh->cfg.ext_fault_en) pCh->prot.ext_fault = 1;
+	else pCh->prot.ext_fault = 0;
 }
 
 /**
@@ -390,19 +453,8 @@ void OUTDRV_SetExtFault(uint8_t ch)
  */
 void OUTDRV_ResetExtFault(uint8_t ch)
 {
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolProt.ext_fault = 0;
-			break;
-			
-		case OUT_IGNC:
-			igncProt.ext_fault = 0;
-			break;
-			
-		default:
-			break;
-	}
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	chTable[ch-1].prot.ext_fault = 0;
 }
 
 /**
@@ -412,216 +464,169 @@ void OUTDRV_ResetExtFault(uint8_t ch)
  */
 void OUTDRV_DelayFaultExecution(uint8_t ch, uint8_t cycles)
 {
+	if((ch==0)||(ch>OUT_COUNT)) return;
+	
 	if(cycles>OUT_FAULT_EXEC_DELAY_LIMIT) cycles = OUT_FAULT_EXEC_DELAY_LIMIT;
 	
-	switch(ch)
-	{
-		case OUT_ISOL:
-			isolProt.delay_exec = cycles; 
-			break;
-			
-		case OUT_IGNC:
-			igncProt.delay_exec = cycles;
-			break;
-			
-		default:
-			break;
-	}
+	chTable[ch-1].prot.delay_exec = cycles;
 }
 
 /**** Private function definitions ****/
 
 /**
- * @brief Ignition output protection processing
- * @param [in] volt_pwrsrc Channels power source voltage in mV
- * @param [in] volt_out Channels output voltage in mV
+ * @brief Output channel protection processing
+ * @param [in] pCh Channel descriptor
+ * @param [in] volt_pwrsrc Channels power source voltage
+ * @param [in] volt_out Channels output voltage
+ * @param [in] pLim Protection limits, same units as voltages
+ * @param [in] fast Voltages are fast 8bit ADC values [0-calibrated counts,1-fast]
+ * @param [in] fresh Output voltage sampled in last scan [0-stale,other-fresh]
  * @return fault indicator
  */
-uint8_t ProcessIgnitionProtection(uint16_t volt_pwrsrc, uint16_t volt_out)
-{		
-	//Calculate mosfet voltage drop
+static uint8_t ProcessChannelProtection(ChannelDef* pCh, uint16_t volt_pwrsrc, uint16_t volt_out, const ProtLimitsDef* pLim, uint8_t fast, uint8_t fresh)
+{
+	ProtectionDef* pProt = &pCh->prot;
+	
+	//Calculate mosfet voltage drop, PWM hold is sampled in on-time
 	uint16_t drop = 0;
-	if((igncState.hw==HWOUT_HIGH)&&(volt_pwrsrc>volt_out)) drop = volt_pwrsrc-volt_out;
-	else if(igncState.hw==HWOUT_LOW) drop = volt_out;
+	if((pCh->state.hw==HWOUT_HIGH)&&(volt_pwrsrc>volt_out)) drop = volt_pwrsrc-volt_out;
+	else if(pCh->state.hw==HWOUT_LOW) drop = volt_out;
 	else drop = 0;
 	
 	//Check Over-Voltage warning
-	if((volt_pwrsrc>IGNC_OVERVOLATGE_LIMIT)&&(IGNC_OVERVOLATGE_LIMIT!=0)) igncProt.ovp_warning = 1;
-	else igncProt.ovp_warning = 0;
+	if((volt_pwrsrc>pLim->ovp)&&(pLim->ovp!=0)) pProt->ovp_warning = 1;
+	else pProt->ovp_warning = 0;
 	
 	//Check Under-Voltage warning
-	if((volt_pwrsrc<IGNC_UNDERVOLATGE_LIMIT)&&(IGNC_UNDERVOLATGE_LIMIT!=0)) igncProt.uvp_warning = 1;
-	else igncProt.uvp_warning = 0;
+	if((volt_pwrsrc<pLim->uvp)&&(pLim->uvp!=0)) pProt->uvp_warning = 1;
+	else pProt->uvp_warning = 0;
 
-	//Check Over-Current warning
-	if((drop>IGNC_QDROP_LIMIT)&&(IGNC_QDROP_LIMIT!=0)) igncProt.ocp_warning = 1;
-	else igncProt.ocp_warning = 0;
-	
-		
-	//Do delay calculations
-	if(igncProt.ocp_deadtime) igncProt.ocp_deadtime--;	
-	//OCP delay
-	if((igncProt.ocp_warning)&&(!igncProt.ocp_deadtime))
+	//Check Over-Current warning, stale sample keeps last state
+	if(fresh)
 	{
-		//Calculate increment
-		uint16_t x = drop/IGNC_QDROP_LIMIT;
-		if(x>255) x = 255;
-		uint8_t inc = (uint8_t)x;
-		
-		//Saturated add
-		uint8_t dtop = 255-igncProt.ocp_counter;
-		if(inc>dtop) igncProt.ocp_counter = 255;
-		else igncProt.ocp_counter += inc;
-	}
-	else
-	{
-		//Saturated subtraction
-		if(igncProt.ocp_counter) igncProt.ocp_counter--;
-	}
+		if((drop>pLim->qdrop)&&(pLim->qdrop!=0)) pProt->ocp_warning = 1;
+		else pProt->ocp_warning = 0;
+	};
 	
+	//Do delay calculations
+	if(pProt->ocp_deadtime) pProt->ocp_deadtime--;
+	//OCP I2t, only cooling in dead time
+	uint16_t i2t_drop = 0;
+	if(fast) i2t_drop = I2T_FROM_FAST(drop);
+	else i2t_drop = I2T_FROM_COUNTS(drop);
 	
-	//Check fault
-	if((igncProt.ovp_warning)||(igncProt.uvp_warning)||(igncProt.ocp_counter>ISOL_OCP_DELAY))
-	{
-		if((!igncProt.fault)&&(igncProt.fault_cnt<255)) igncProt.fault_cnt++;
+	//Instant trip window, only on settled full drive
+	uint16_t win_low = ADC_WIN_LOW_OFF;
+	uint16_t win_high = ADC_WIN_HIGH_OFF;
+	uint8_t comp = CMP_TRIP_NONE;
+	if((!pProt->ocp_deadtime)&&(!pProt->slope_rst))
+	{
+		uint16_t lim = pCh->pPar->inst_lim;
+		uint16_t src = volt_pwrsrc;
+		if(fast) src <<= 2;
 		
-		igncProt.fault = 1;
-		
-		if(!igncProt.cooldown_timer)
+		if(pCh->state.hw==HWOUT_LOW)
 		{
-			igncProt.cooldown_timer = IGNC_FAULT_COOLDOWN_TIME;
-		};
-	}
-	else
-	{
-		//Wait for fault cooldown time
-		if(igncProt.cooldown_timer) igncProt.cooldown_timer--;
-		else
-		{
-			//Fault ended
-			if(igncProt.fault)
-			{
-				igncProt.fault = 0;
-				igncProt.retry_flag = 1;
-				igncProt.retry_timer = IGNC_FAULT_RETRY_TIMEOUT;
-			}
-			else
-			{
-				if(igncProt.retry_timer) igncProt.retry_timer--;
-				else igncProt.fault_cnt = 0;
-			}
+			win_high = lim;
+			//Every PWM off-time is a rising output
+			if(!pCh->state.hold) comp = CMP_TRIP_ABOVE;
 		}
-	}
-	
-	return igncProt.fault;
-}
-
-/**
- * @brief Isolator output protection processing
- * @param [in] volt_pwrsrc Channels power source voltage in mV
- * @param [in] volt_out Channels output voltage in mV
- * @return fault indicator
- */
-uint8_t ProcessIsolatorProtection(uint16_t volt_pwrsrc, uint16_t volt_out)
-{		
-	//Calculate mosfet voltage drop
-	uint16_t drop = 0;
-	if((isolState.hw==HWOUT_HIGH)&&(volt_pwrsrc>volt_out)) drop = volt_pwrsrc-volt_out;
-	else if(isolState.hw==HWOUT_LOW) drop = volt_out;
-	else drop = 0;
+		else if(pCh->state.hw==HWOUT_HIGH)
+		{
+			if(src>lim) win_low = src-lim;
+			comp = CMP_TRIP_BELOW;
+		};
+	};
+	ADCDRV_SetWindow(pCh->adc_out,win_low,win_high);
 	
-	//Check Over-Voltage warning
-	if((volt_pwrsrc>ISOL_OVERVOLATGE_LIMIT)&&(ISOL_OVERVOLATGE_LIMIT!=0)) isolProt.ovp_warning = 1;
-	else isolProt.ovp_warning = 0;
+	//Comparator follows window, trip present at arm is forced here
+	if((pCh->cfg.comp_trip)&&(comp!=CMPDRV_GetArmed()))
+	{
+		if(CMPDRV_Arm(comp)) HAL_ForceHiZ(pCh);
+	};
 	
-	//Check Under-Voltage warning
-	if((volt_pwrsrc<ISOL_UNDERVOLATGE_LIMIT)&&(ISOL_UNDERVOLATGE_LIMIT!=0)) isolProt.uvp_warning = 1;
-	else isolProt.uvp_warning = 0;
-
-	//Check Over-Current warning
-	if((drop>ISOL_QDROP_LIMIT)&&(ISOL_QDROP_LIMIT!=0)) isolProt.ocp_warning = 1;
-	else isolProt.ocp_warning = 0;
+	//Instant trip from ADC ISR, output is already HiZ
+	uint8_t inst_trip = 0;
+	if(trip_pins&(pCh->pin_hs|pCh->pin_ls)) inst_trip = 1;
 	
-	//Do delay calculations	
-	if(isolProt.ocp_deadtime) isolProt.ocp_deadtime--;
-	//OCP Delay
-	if((isolProt.ocp_warning)&&(!isolProt.ocp_deadtime))
+	uint8_t ocp_trip = 0;
+	if(fresh)
 	{
-		//Calculate increment
-		uint16_t x = drop/ISOL_QDROP_LIMIT;
-		if(x>255) x = 255;
-		uint8_t inc = (uint8_t)x;
-		
-		//Saturated add
-		uint8_t dtop = 255-isolProt.ocp_counter;
-		if(inc>dtop) isolProt.ocp_counter = 255;
-		else isolProt.ocp_counter += inc;
-	}
-	else
-	{
-		//Saturated subtraction
-		if(isolProt.ocp_counter) isolProt.ocp_counter--;
-	}
+		if(pProt->ocp_deadtime) ocp_trip = I2TDRV_Update(&pProt->ocp_i2t,0);
+		else ocp_trip = I2TDRV_Update(&pProt->ocp_i2t,i2t_drop);
+	};
 	
+	//Predictive trip, restart on new level, dead time and hold start
+	uint8_t slope_trip = 0;
+	if(pProt->ocp_deadtime) pProt->slope_rst = 1;
+	if(fresh)
+	{
+		if(pProt->slope_rst)
+		{
+			SLPDRV_Reset(&pProt->ocp_slope,i2t_drop);
+			pProt->slope_rst = 0;
+		}
+		else slope_trip = SLPDRV_Update(&pProt->ocp_slope,i2t_drop);
+	};
 	
 	//Check fault
-	if((isolProt.ovp_warning)||(isolProt.uvp_warning)||(isolProt.ocp_counter>ISOL_OCP_DELAY))
+	if((pProt->ovp_warning)||(pProt->uvp_warning)||(ocp_trip)||(slope_trip)||(inst_trip))
 	{
-		if((!isolProt.fault)&&(isolProt.fault_cnt<255)) isolProt.fault_cnt++;
+		if((!pProt->fault)&&(pProt->fault_cnt<255)) pProt->fault_cnt++;
 		
-		isolProt.fault = 1;
+		pProt->fault = 1;
 		
-		if(!isolProt.cooldown_timer)
+		if(!pProt->cooldown_timer)
 		{
-			isolProt.cooldown_timer = ISOL_FAULT_COOLDOWN_TIME;
+			pProt->cooldown_timer = pCh->pPar->cooldown_time;
 		};
 	}
 	else
 	{
 		//Wait for fault cooldown time
-		if(isolProt.cooldown_timer) isolProt.cooldown_timer--;
+		if(pProt->cooldown_timer) pProt->cooldown_timer--;
 		else
 		{
 			//Fault ended
-			if(isolProt.fault)
+			if(pProt->fault)
 			{
-				isolProt.fault = 0;
-				isolProt.retry_flag = 1;
-				isolProt.retry_timer = ISOL_FAULT_RETRY_TIMEOUT;
+				pProt->fault = 0;
+				pProt->retry_flag = 1;
+				pProt->retry_timer = pCh->pPar->retry_timeout;
 			}
 			else
 			{
-				if(isolProt.retry_timer) isolProt.retry_timer--;
-				else isolProt.fault_cnt = 0;
+				if(pProt->retry_timer) pProt->retry_timer--;
+				else pProt->fault_cnt = 0;
 			}
 		}
 	}
 	
-	return isolProt.fault;
+	return pProt->fault;
 }
 
 /**
  * @brief Convert logic level output state to HW level output
- * @param [in] cfg Channel configuration data
+ * @param [in] pCfg Channel configuration data
  * @param [in] state State to set [0-off,1-on]
  * @return HW level to set
  */
-uint8_t StateToHWLevel(outConfigDef cfg, uint8_t state)
+static uint8_t StateToHWLevel(const outConfigDef* pCfg, uint8_t state)
 {	
 	uint8_t level = HWOUT_HIZ;
 	
-	switch (cfg.type)
+	switch (pCfg->type)
 	{
 		case OUT_TYPE_PP :
 			//Push-pull output
 			if(state)
 			{
-				if(cfg.inv) level = HWOUT_LOW;
+				if(pCfg->inv) level = HWOUT_LOW;
 				else level = HWOUT_HIGH;
 			}
 			else
 			{
-				if(cfg.inv) level = HWOUT_HIGH;
+				if(pCfg->inv) level = HWOUT_HIGH;
 				else level = HWOUT_LOW;
 			}
 			break;
@@ -652,71 +657,110 @@ uint8_t StateToHWLevel(outConfigDef cfg, uint8_t state)
 /**
  * @brief Initializes hardware
  */
-void HAL_Init(void)
+static void HAL_Init(void)
 {	
+	uint8_t pins = 0;
+	for(uint8_t i=0; i<OUT_COUNT; i++)
+	{
+		pins |= chTable[i].pin_hs|chTable[i].pin_ls;
+		chTable[i].state.hw = HWOUT_HIZ;
+	}
+	out_pins = pins;
+	
 	//Disable pull-ups on PORTB
 	PORTCR |= 0x02;
 	//Brake-Before-make on PORTB
 	PORTCR |= 0x20;
 	
 	//GPIO configuration, set HiZ output
-	PORTB &= ~0xC3; //Set low
-	DDRB |= 0xC3;   //Set as output
-	
-	isolState.hw = HWOUT_HIZ;
-	igncState.hw = HWOUT_HIZ;
+	PORTB &= ~pins; //Set low
+	DDRB |= pins;   //Set as output
 }
 
 /**
- * @brief Ignition output low level control and logic protection
- * @param [in] level Output level [0-HiZ/1-low/2-high]
+ * @brief Write all channel output pins
+ * @param [in] pins PORTB pattern of all channels
+ * @param [in] bbm Pins of channels changing direction, turned off first
  */
-void HAL_SetIgnition(uint8_t level)
+static void HAL_WritePins(uint8_t pins, uint8_t bbm)
 {
-	if(level!=igncState.hw) igncProt.ocp_deadtime = IGNC_OCP_DEAD_TIME;
-	
-	if(level==HWOUT_HIGH)
-	{
-		PORTB &= ~0x01; //Reset low side
-		PORTB |= 0x40;  //Set high side
-		igncState.hw = HWOUT_HIGH;
-	}
-	else if(level==HWOUT_LOW)
-	{
-		PORTB &= ~0x40; //Reset high side
-		PORTB |= 0x01;  //Set low side
-		igncState.hw = HWOUT_LOW;
-	}
-	else
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		PORTB &= ~0x41; //Reset high & low side
-		igncState.hw = HWOUT_HIZ;
+		uint8_t port = PORTB&~out_pins;
+		
+		//Tripped channels stay HiZ until logic turns them off
+		pins &= ~trip_pins;
+		
+		//Break-before-make
+		if(bbm) PORTB = port|(pins&~bbm);
+		
+		PORTB = port|pins;
 	}
 }
 
 /**
- * @brief Isolator output low level control and logic protection
- * @param [in] level Output level [0-HiZ/1-low/2-high]]
+ * @brief Start Timer1 PWM on OC1A (PB1), on-time starts at BOTTOM
+ * @param [in] duty PWM duty, 0-255
  */
-void HAL_SetIsolator(uint8_t level)
+static void HAL_StartPwm(uint8_t duty)
 {
-	if(level!=isolState.hw) isolProt.ocp_deadtime = ISOL_OCP_DEAD_TIME;
+	PRR &= ~0x08; //Timer1 power on
 	
-	if(level==HWOUT_HIGH)
-	{
-		PORTB &= ~0x02; //Reset low side
-		PORTB |= 0x80;  //Set high side
-		isolState.hw = HWOUT_HIGH;
-	}
-	else if(level==HWOUT_LOW)
+	TCNT1 = 0;
+	OCR1A = ((uint16_t)duty)<<1;
+	TCCR1A = 0x82; //OC1A non-inverting, fast PWM 9bit
+	TCCR1B = 0x09; //Fast PWM 9bit, no prescaler
+}
+
+/**
+ * @brief Stop Timer1 PWM, OC1A (PB1) is controlled by PORTB again
+ */
+static void HAL_StopPwm(void)
+{
+	TCCR1A = 0x00; //OC1A disconnected
+	TCCR1B = 0x00; //Timer stopped
+	
+	PRR |= 0x08; //Timer1 power off
+}
+
+/**
+ * @brief Instant trip, ADC window handler, called from ADC ISR
+ * @param [in] adc_ch ADC channel outside of window
+ */
+static void HAL_InstantTrip(uint8_t adc_ch)
+{
+	for(uint8_t i=0; i<OUT_COUNT; i++)
 	{
-		PORTB &= ~0x80; //Reset high side
-		PORTB |= 0x02;  //Set low side
-		isolState.hw = HWOUT_LOW;
+		ChannelDef* pCh = &chTable[i];
+		if(pCh->adc_out!=adc_ch) continue;
+		
+		HAL_ForceHiZ(pCh);
+		ADCDRV_SetWindow(adc_ch,ADC_WIN_LOW_OFF,ADC_WIN_HIGH_OFF);
 	}
-	else
+}
+
+/**
+ * @brief Comparator trip handler, called from comparator ISR
+ */
+static void HAL_CompTrip(void)
+{
+	if(comp_idx<OUT_COUNT) HAL_ForceHiZ(&chTable[comp_idx]);
+}
+
+/**
+ * @brief Force channel HiZ and mark its pins until logic turns it off
+ * @param [in] pCh Channel descriptor
+ */
+static void HAL_ForceHiZ(ChannelDef* pCh)
+{
+	uint8_t pins = pCh->pin_hs|pCh->pin_ls;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
 	{
-		PORTB &= ~0x82; //Reset high & low side
-		isolState.hw = HWOUT_HIZ;
+		//PWM overrides port pin, Timer1 keeps running for synchronized ADC
+		if(pCh->pwm_ls) TCCR1A &= ~0xC0; //OC1A disconnected
+		
+		PORTB &= ~pins; //Reset high & low side
+		trip_pins |= pins;
 	}
-}
\ No newline at end of file
+}
@@ -6,6 +6,17 @@ Author: Andis Jargans
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Fast 8bit ADC protection path
+2026-10-16: Output configuration table
+2026-10-16: Relay economizer, pull-in time and PWM hold duty
+2026-10-16: I2t over-current protection time constants
+2026-10-16: Predictive slope trip parameters
+2026-10-16: Instant trip level for ADC ISR window
+2026-10-16: Analog comparator short detector channel
+2026-10-16: Stale output samples skipped by protection
+2026-10-16: PWM hold plausibility limit
+2026-10-16: I2t time constant from inrush profile
+2026-10-16: Minimum hold duty for on-time sampling, no hold plausibility limit
 */
 
 #ifndef OUT_DRIVER
@@ -16,40 +27,56 @@ Revision history:
 /**** Public definitions ****/
 #define OUT_ISOL	1
 #define OUT_IGNC	2
+#define OUT_COUNT	2
 
 #define OUT_TYPE_OD	1
 #define OUT_TYPE_OS	2
 #define OUT_TYPE_PP	3
 
+#define OUT_DUTY_PCT(pct)	((uint8_t)(((pct)*255UL)/100))	//Hold duty from percent
+#define OUT_HOLD_DUTY_MIN	OUT_DUTY_PCT(35)	//On-time covers ADC sample delay after Timer1 overflow
+#define OUT_FRESH(ch)		(1<<((ch)-1))	//Fresh output sample mask bit of channel
+
 typedef struct outConfigStruct {
 	uint8_t type;
 	uint8_t inv;
 	uint8_t ext_fault_en;
+	uint16_t pullin_time;	//Full drive time before PWM hold, ticks, 0-economizer off
+	uint8_t hold_duty;		//PWM hold duty, 0-255
+	uint8_t comp_trip;		//Short detector on analog comparator, first such channel only
 }outConfigDef;
 
 /**** Aplciation specific configuration ****/
 #define ISOL_OVERVOLATGE_LIMIT		0
 #define ISOL_UNDERVOLATGE_LIMIT		0
 #define ISOL_QDROP_LIMIT			500
-#define ISOL_OCP_DELAY				2
+#define ISOL_OCP_TAU				4	//I2t cooling time constant, 2^N output samples, inrush margin
 #define ISOL_FAULT_COOLDOWN_TIME	2000
 #define ISOL_OCP_DEAD_TIME			0
 #define ISOL_FAULT_RETRY_TIMEOUT	2000
+#define ISOL_QDROP_HARD_LIMIT		1500	//Predictive trip, projected drop
+#define ISOL_QDROP_SLOPE			100		//Predictive trip, min mV per output sample
+#define ISOL_QDROP_HORIZON			2		//Predictive trip, 2^N output samples ahead
+#define ISOL_QDROP_INSTANT			3000	//Instant trip in ADC ISR, mV
 
 #define IGNC_OVERVOLATGE_LIMIT		0
 #define IGNC_UNDERVOLATGE_LIMIT		0
 #define IGNC_QDROP_LIMIT			500
-#define IGNC_OCP_DELAY				2
+#define IGNC_OCP_TAU				4	//I2t cooling time constant, 2^N output samples, inrush margin
 #define IGNC_FAULT_COOLDOWN_TIME	2000
 #define IGNC_OCP_DEAD_TIME			0
 #define IGNC_FAULT_RETRY_TIMEOUT	2000
+#define IGNC_QDROP_HARD_LIMIT		1500	//Predictive trip, projected drop
+#define IGNC_QDROP_SLOPE			100		//Predictive trip, min mV per output sample
+#define IGNC_QDROP_HORIZON			2		//Predictive trip, 2^N output samples ahead
+#define IGNC_QDROP_INSTANT			3000	//Instant trip in ADC ISR, mV
 
 #define OUT_FAULT_EXEC_DELAY_LIMIT	5
 
 
 /**** Public function declarations ****/
 //Control functions
-void OUTDRV_Init(outConfigDef* pIsolCfg, outConfigDef* pIgncCfg);
+void OUTDRV_Init(const outConfigDef* pCfg);
 void OUTDRV_SetOutput(uint8_t ch);
 void OUTDRV_ResetOutput(uint8_t ch);
 void OUTDRV_SetExtFault(uint8_t ch);
@@ -60,7 +87,8 @@ void OUTDRV_DelayFaultExecution(uint8_t ch, uint8_t cycles);
 
 //Interrupt and loop functions
 void OUTDRV_ProcessLogic(void);
-void OUTDRV_ProcessProtection(uint16_t u_bat, uint16_t u_isol, uint16_t u_alt, uint16_t u_ignc);
+void OUTDRV_ProcessProtection(uint16_t u_bat, uint16_t u_isol, uint16_t u_alt, uint16_t u_ignc, uint8_t fresh);
+void OUTDRV_ProcessFastProtection(uint8_t c_bat, uint8_t c_isol, uint8_t c_alt, uint8_t c_ignc, uint8_t fresh);
 
 //Data retrieve functions
 uint8_t OUTDRV_GetFault(uint8_t ch);
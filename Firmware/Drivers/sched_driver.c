@@ -0,0 +1,106 @@
+/*
+Battery isolator controller
+Cooperative task scheduler
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, static multi-rate task table
+2026-10-16: Short driver description
+*/
+
+/**** Description ****
+Due tasks run to completion in table order, each with own period and phase in
+ticks. Run gets ticks elapsed since last call, missed releases are counted as
+overruns.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include "sched_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+static const schTaskDef* pTasks = 0;
+static uint8_t task_cnt = 0;
+static uint16_t task_timer[SCH_TASK_MAX];
+static uint16_t run_cnt[SCH_TASK_MAX];
+static uint16_t overrun_cnt[SCH_TASK_MAX];
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes scheduler with static task table
+ * @param [in] pTable Task table, must stay valid
+ * @param [in] count Task count [1 to SCH_TASK_MAX]
+ */
+void SCHDRV_Init(const schTaskDef* pTable, uint8_t count)
+{
+	if(count>SCH_TASK_MAX) count = SCH_TASK_MAX;
+	
+	pTasks = pTable;
+	task_cnt = count;
+	
+	for(uint8_t i=0; i<count; i++)
+	{
+		uint16_t phase = pTable[i].phase;
+		if(phase>=pTable[i].period) phase = 0;
+		task_timer[i] = phase+1; //First run on tick phase+1
+		run_cnt[i] = 0;
+		overrun_cnt[i] = 0;
+	}
+}
+
+/**
+ * @brief Run due tasks
+ * @param [in] ticks Ticks elapsed since last call
+ */
+void SCHDRV_Run(uint8_t ticks)
+{
+	for(uint8_t i=0; i<task_cnt; i++)
+	{
+		uint16_t period = pTasks[i].period;
+		uint16_t t = task_timer[i];
+		
+		if(ticks<t)
+		{
+			task_timer[i] = t-ticks;
+			continue;
+		};
+		
+		//Ticks past due time, every full period is a missed release
+		uint16_t late = ticks-t;
+		if(period==0) period = 1;
+		while(late>=period)
+		{
+			late -= period;
+			overrun_cnt[i]++;
+		}
+		task_timer[i] = period-late;
+		
+		run_cnt[i]++;
+		pTasks[i].pTask();
+	}
+}
+
+/**
+ * @brief Get task run count
+ * @param [in] id Task index in table
+ * @return Run count
+ */
+uint16_t SCHDRV_GetRunCount(uint8_t id)
+{
+	if(id>=task_cnt) return 0;
+	return run_cnt[id];
+}
+
+/**
+ * @brief Get task overrun count
+ * @param [in] id Task index in table
+ * @return Missed releases count
+ */
+uint16_t SCHDRV_GetOverruns(uint8_t id)
+{
+	if(id>=task_cnt) return 0;
+	return overrun_cnt[id];
+}
@@ -0,0 +1,36 @@
+/*
+Battery isolator controller
+Cooperative task scheduler
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, static multi-rate task table
+*/
+
+#ifndef SCHED_DRIVER
+#define SCHED_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define SCH_TASK_MAX	8
+
+typedef struct SchTaskStruct {
+	void (*pTask)(void);
+	uint16_t period; //ticks
+	uint16_t phase; //ticks, offset of first run [0 to period-1]
+}schTaskDef;
+
+/**** Public function declarations ****/
+//Control functions
+void SCHDRV_Init(const schTaskDef* pTable, uint8_t count);
+
+//Interrupt and loop functions
+void SCHDRV_Run(uint8_t ticks);
+
+//Data retrieve functions
+uint16_t SCHDRV_GetRunCount(uint8_t id);
+uint16_t SCHDRV_GetOverruns(uint8_t id);
+
+#endif
@@ -0,0 +1,95 @@
+/*
+Battery isolator controller
+Slope based predictive over-current trip
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, EMA slope, power of two horizon
+2026-10-16: Short driver description
+*/
+
+/**** Description ****
+Slope is EMA (alpha 1/2, 2 fraction bits) of drop differences. Trip when drop
+projected 2^horizon updates ahead is over hard limit, slope is at least
+min_slope and drop is at least half of hard limit. Caller resets estimator
+after switching or gaps in samples. Shifts only.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include "slope_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes slope estimator
+ * @param [in] pSlp Estimator
+ * @param [in] limit Hard drop limit
+ * @param [in] min_slope Minimum slope for trip, drop units per update, 2 fraction bits
+ * @param [in] horizon Projection 2^horizon updates ahead [0 to SLP_HORIZON_MAX]
+ */
+void SLPDRV_Init(slopeDef* pSlp, uint16_t limit, int16_t min_slope, uint8_t horizon)
+{
+	if(limit>SLP_DROP_MAX) limit = SLP_DROP_MAX;
+	if(horizon>SLP_HORIZON_MAX) horizon = SLP_HORIZON_MAX;
+	
+	pSlp->limit = limit;
+	pSlp->arm = limit>>1;
+	pSlp->min_slope = min_slope;
+	pSlp->horizon = horizon;
+	
+	SLPDRV_Reset(pSlp,0);
+}
+
+/**
+ * @brief Restart estimator from current drop, slope is cleared
+ * @param [in] pSlp Estimator
+ * @param [in] drop Current drop
+ */
+void SLPDRV_Reset(slopeDef* pSlp, uint16_t drop)
+{
+	if(drop>SLP_DROP_MAX) drop = SLP_DROP_MAX;
+	
+	pSlp->prev = drop;
+	pSlp->slope = 0;
+}
+
+/**
+ * @brief Update slope with new drop sample
+ * @param [in] pSlp Estimator
+ * @param [in] drop Drop sample, one per update period
+ * @return Predictive trip [0-no,1-projected drop over hard limit]
+ */
+uint8_t SLPDRV_Update(slopeDef* pSlp, uint16_t drop)
+{
+	if(drop>SLP_DROP_MAX) drop = SLP_DROP_MAX;
+	
+	//EMA of difference, alpha 1/2
+	int16_t diff = (int16_t)(drop-pSlp->prev)<<2;
+	int16_t slope = (pSlp->slope+diff)>>1;
+	pSlp->slope = slope;
+	pSlp->prev = drop;
+	
+	if((slope<pSlp->min_slope)||(slope<=0)) return 0;
+	if(drop<pSlp->arm) return 0;
+	
+	//Projected drop
+	uint16_t proj = drop+(((uint16_t)slope<<pSlp->horizon)>>2);
+	
+	if(proj>pSlp->limit) return 1;
+	else return 0;
+}
+
+/**
+ * @brief Get slope
+ * @param [in] pSlp Estimator
+ * @return Slope, drop units per update, 2 fraction bits
+ */
+int16_t SLPDRV_GetSlope(const slopeDef* pSlp)
+{
+	return pSlp->slope;
+}
@@ -0,0 +1,43 @@
+/*
+Battery isolator controller
+Slope based predictive over-current trip
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, EMA slope, power of two horizon
+*/
+
+#ifndef SLOPE_DRIVER
+#define SLOPE_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define SLP_DROP_MAX	1023	//Drop clamp, keeps slope math in 16bit
+#define SLP_HORIZON_MAX	3		//Max projection 2^3 updates ahead
+
+//Convert mV per update to slope units, drop in 40mV units, 2 fraction bits
+#define SLP_MV_TO_SLOPE(mv)	((mv)/10)
+
+typedef struct slopeStruct {
+	uint16_t prev;
+	int16_t slope;		//Drop units per update, 2 fraction bits
+	int16_t min_slope;	//Same units as slope
+	uint16_t limit;		//Hard drop limit
+	uint16_t arm;		//Drop needed for prediction, half of limit
+	uint8_t horizon;	//Projection 2^horizon updates ahead
+}slopeDef;
+
+/**** Public function declarations ****/
+//Control functions
+void SLPDRV_Init(slopeDef* pSlp, uint16_t limit, int16_t min_slope, uint8_t horizon);
+void SLPDRV_Reset(slopeDef* pSlp, uint16_t drop);
+
+//Interrupt and loop functions
+uint8_t SLPDRV_Update(slopeDef* pSlp, uint16_t drop);
+
+//Data retrieve functions
+int16_t SLPDRV_GetSlope(const slopeDef* pSlp);
+
+#endif
@@ -0,0 +1,214 @@
+/*
+Battery isolator controller
+System tick driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, Timer0 1ms tick
+2026-10-16: Idle sleep until tick, busy time measurement
+2026-10-16: Timer0 settings follow CPU clock divider
+2026-10-16: Short busy-wait delay from Timer0 count
+2026-10-16: 8us timestamp
+2026-10-16: Short driver description
+*/
+
+/**** Hardware configuration ****
+TIMER0 - system tick, CTC mode, compare match A interrupt
+
+Ftick = Fcpu/(DIV*(OCR0A+1))
+8MHz/(64*125) = 1kHz
+2MHz/(8*250) = 1kHz
+1MHz/(8*125) = 1kHz
+Timer0 is reconfigured on CPU clock change, so tick stays 1ms. It runs from
+clkIO, only Idle sleep keeps it running. WaitTick saves Timer0 count as busy
+time of the tick (8us units) before sleeping.
+*/
+
+/**** Includes ****/
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <util/atomic.h>
+#include "systick_driver.h"
+
+/**** Private definitions ****/
+
+/**** Private variables ****/
+static volatile uint16_t time_ms = 0;
+static volatile uint8_t tick_cnt = 0;
+static volatile uint8_t busy = 0;
+static uint8_t busy_shift = 0;
+
+/**** Public function definitions ****/
+/**
+ * @brief Initializes Timer0 as system tick
+ */
+void TICKDRV_Init(void)
+{
+	PRR &= ~0x20; //Enable TIMER0 power
+	TCCR0A = 0x00; //Stop timer
+	TCNT0 = 0x00;
+	OCR0A = 124; //1ms @1MHz/8
+	TIFR0 = 0x02; //Clear compare A flag
+	TIMSK0 = 0x02; //Compare A interrupt enable
+	TCCR0A = 0x0A; //CTC mode, DIV=8
+	
+	time_ms = 0;
+	tick_cnt = 0;
+	busy_shift = 0;
+}
+
+/**
+ * @brief Set Timer0 for CPU clock, call with interrupts disabled
+ * @param [in] cpu_div CPU clock divider, CLKPR CLKPS value [0-8MHz,2-2MHz,3-1MHz]
+ */
+void TICKDRV_SetClock(uint8_t cpu_div)
+{
+	switch(cpu_div)
+	{
+		case 0:
+			OCR0A = 124;
+			TCCR0A = 0x0B; //CTC mode, DIV=64
+			busy_shift = 0;
+			break;
+		
+		case 2:
+			OCR0A = 249;
+			TCCR0A = 0x0A; //CTC mode, DIV=8
+			busy_shift = 1;
+			break;
+		
+		case 3:
+			OCR0A = 124;
+			TCCR0A = 0x0A; //CTC mode, DIV=8
+			busy_shift = 0;
+			break;
+		
+		default:
+			return;
+	}
+	
+	//Compare match would be missed above TOP
+	if(TCNT0>OCR0A) TCNT0 = 0;
+}
+
+/**
+ * @brief Sleep in Idle mode until next system tick
+ * @return Ticks elapsed since last call, more than 1 means loop overrun
+ */
+uint8_t TICKDRV_WaitTick(void)
+{
+	uint8_t cnt = 0;
+	
+	cli();
+	//Time spent since tick
+	if(tick_cnt) busy = TICK_BUSY_FULL;
+	else busy = TCNT0>>busy_shift;
+	
+	while(!tick_cnt)
+	{
+		SMCR = 0x01; //Idle mode, sleep enable
+		sei();
+		sleep_cpu(); //sei() guarantees one instruction before any interrupt
+		SMCR = 0x00; //Sleep disable
+		cli(); //ADC interrupt may wake CPU too
+	}
+	
+	cnt = tick_cnt;
+	tick_cnt = 0;
+	sei();
+	
+	return cnt;
+}
+
+/**
+ * @brief Busy-wait delay, counted on Timer0
+ * @param [in] us Delay in us, 8us resolution, rounded up
+ */
+void TICKDRV_DelayUs(uint16_t us)
+{
+	uint16_t target = ((us+7)>>3)<<busy_shift;
+	uint16_t cnt = 0;
+	uint8_t last = TCNT0;
+	
+	//Timer0 not powered
+	if(PRR&0x20) return;
+	
+	while(cnt<target)
+	{
+		uint8_t now = TCNT0;
+		if(now>=last) cnt += now-last;
+		else cnt += (OCR0A+1-last)+now; //Wrapped at TOP
+		last = now;
+	}
+}
+
+/**
+ * @brief Get system time
+ * @return Time in ms since init, wraps at 65535
+ */
+uint16_t TICKDRV_GetTime(void)
+{
+	uint16_t t = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		t = time_ms;
+	}
+	
+	return t;
+}
+
+/**
+ * @brief Get time elapsed since timestamp
+ * @param [in] since Timestamp from TICKDRV_GetTime
+ * @return Elapsed time in ms
+ */
+uint16_t TICKDRV_GetElapsed(uint16_t since)
+{
+	return TICKDRV_GetTime()-since;
+}
+
+/**
+ * @brief Get timestamp for latency measurement, can be called from ISR
+ * @return Time in 8us units, wraps every 524ms
+ */
+uint16_t TICKDRV_GetStamp(void)
+{
+	uint16_t ms = 0;
+	uint8_t cnt = 0;
+	
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		ms = time_ms;
+		cnt = TCNT0;
+		if(TIFR0&0x02)
+		{
+			//Compare match pending, tick not counted yet
+			ms += TICK_PERIOD_MS;
+			cnt = TCNT0;
+		};
+	}
+	
+	return ms*TICK_BUSY_FULL+(cnt>>busy_shift);
+}
+
+/**
+ * @brief Get busy time of last tick
+ * @return Time from tick to WaitTick call, 8us units [0 to TICK_BUSY_FULL]
+ */
+uint8_t TICKDRV_GetBusy(void)
+{
+	return busy;
+}
+
+/**** Interrupt handlers ****/
+/**
+ * @brief Timer0 compare match, system tick
+ */
+ISR(TIMER0_COMPA_vect)
+{
+	time_ms += TICK_PERIOD_MS;
+	if(tick_cnt<255) tick_cnt++;
+}
@@ -0,0 +1,39 @@
+/*
+Battery isolator controller
+System tick driver
+
+Author: Andis Jargans
+
+Revision history:
+2026-10-16: Initial version, Timer0 1ms tick
+2026-10-16: Idle sleep until tick, busy time measurement
+2026-10-16: Timer0 settings follow CPU clock divider
+2026-10-16: Short busy-wait delay from Timer0 count
+2026-10-16: 8us timestamp
+*/
+
+#ifndef SYSTICK_DRIVER
+#define SYSTICK_DRIVER
+
+/**** Includes ****/
+
+/**** Public definitions ****/
+#define TICK_PERIOD_MS	1
+#define TICK_BUSY_FULL	125	//Busy time of whole tick, 8us units
+
+/**** Public function declarations ****/
+//Control functions
+void TICKDRV_Init(void);
+void TICKDRV_SetClock(uint8_t cpu_div);
+
+//Interrupt and loop functions
+uint8_t TICKDRV_WaitTick(void);
+void TICKDRV_DelayUs(uint16_t us);
+
+//Data retrieve functions
+uint16_t TICKDRV_GetTime(void);
+uint16_t TICKDRV_GetElapsed(uint16_t since);
+uint8_t TICKDRV_GetBusy(void);
+uint16_t TICKDRV_GetStamp(void);
+
+#endif
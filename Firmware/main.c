@@ -13,6 +13,37 @@ SET3|Relay-fuse   | EN   | Disable |
 
 Revision history:
 2021-09-14: Initial version
+2026-10-16: Interrupt driven ADC scan
+2026-10-16: Free-running ADC, conversions overlap main loop processing
+2026-10-16: Relay drop from filtered BAT/ALT, MOSFET protection from raw values
+2026-10-16: Fast 8bit protection scans interleaved with precise 10bit scans
+2026-10-16: Skew compensated relay drop on fast protection scans
+2026-10-16: Median spike filter on BAT and ALT
+2026-10-16: Protection and relay drop in calibrated ADC counts
+2026-10-16: Main loop paced by Timer0 1ms system tick, timeouts in ms
+2026-10-16: Multi-rate cooperative task table
+2026-10-16: Idle sleep between ticks, per-state load and current benchmark
+2026-10-16: Power-down SLEEP state, pin change wake-up on master switch
+2026-10-16: CPU clock scaling per system state
+2026-10-16: Strobed switch pull-up supplies
+2026-10-16: Pin change kill capture, kill latency measurement
+2026-10-16: Inputs configured by table
+2026-10-16: Asymmetric assert/release debounce, integrating kill debounce
+2026-10-16: Switch bounce characterization, auto-tuned debounce limits
+2026-10-16: Outputs configured by table
+2026-10-16: Isolator relay economizer, pull-in then PWM hold
+2026-10-16: I2t relay over-current protection
+2026-10-16: Predictive relay trip on drop slope
+2026-10-16: Optional analog comparator short detector on isolator output
+2026-10-16: MOSFET protection only from output samples of last scan
+2026-10-16: Relay I2t and slope from one unfiltered drop, interleave on single scans
+2026-10-16: Skew compensated relay drop on precise scans too
+2026-10-16: Scan started after output logic, samples show current output levels
+2026-10-16: Wake-up debounce paced by system tick
+2026-10-16: Fast protection scans only at full CPU clock
+2026-10-16: 2MHz slow clock, scan every Nth tick at slow clock
+2026-10-16: Odd precise scan period, precise scans alternate scan list halves
+2026-10-16: Alternator rundown from filtered ALT, no unused filtered values
 */
 
 /**** Hardware configuration **** 
@@ -21,13 +52,20 @@ Revision history:
 /**** Includes ****/
 #include <avr/io.h>
 #include <avr/wdt.h>
-//#include <avr/interrupt.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
 
 #include "Drivers/adc_driver.h"
 #include "Drivers/bootstrap_driver.h"
 #include "Drivers/outputs_driver.h"
 #include "Drivers/inputs_driver.h"
 #include "Drivers/led_driver.h"
+#include "Drivers/systick_driver.h"
+#include "Drivers/sched_driver.h"
+#include "Drivers/clock_driver.h"
+#include "Drivers/i2t_driver.h"
+#include "Drivers/slope_driver.h"
+#include "Drivers/comp_driver.h"
 
 /**** Private definitions ****/
 #define SLEEP		0
@@ -39,43 +77,109 @@ Revision history:
 /**** Aplciation specific configuration ****/
 #define DEVELOPMENT
 //#define WDT_ENABLED
+//#define ADC_FREE_RUNNING	//Not with ADC_FAST_PROTECTION, resolution change every few ticks restarts conversions
+//#define BENCHMARK	//Per-state CPU load and supply current estimate
+#define SLEEP_POWER_DOWN	//Power-down in SLEEP state, wake-up by master switch
+#define CLOCK_FAST		CLK_8MHZ	//STARTUP, ACTIVE and KILLING, protection latency
+#define CLOCK_SLOW		CLK_2MHZ	//LOCKOUT and SLEEP, 1MHz can't fit scan ISRs and tasks in a tick
+#define ADC_FAST_PROTECTION
+#define ADC_SLOW_PERIOD			8	//Ticks per scan at slow clock, scan outlasts a tick there
+#define ADC_PRECISE_PERIOD		3	//Every Nth scan is 10bit, others fast 8bit, odd: scan list has 2 frames
 #define ISOLATOR_DROP_LIMIT		500
-#define ISOLATOR_DROP_DELAY		20
-#define ISOLATOR_OCP_COOLDOWN	1000
-#define ISOLATOR_OCP_DEADTIME	5
+#define ISOLATOR_DROP_TAU		5	//I2t cooling time constant, 2^N ticks
+#define ISOLATOR_DROP_HARD		1500	//Predictive trip, projected relay drop, mV
+#define ISOLATOR_DROP_SLOPE		100		//Predictive trip, min mV per tick
+#define ISOLATOR_DROP_HORIZON	2		//Predictive trip, 2^N ticks ahead
+#define ISOLATOR_OCP_COOLDOWN	1000	//ms
+#define ISOLATOR_OCP_DEADTIME	5		//ms
+#define ISOLATOR_SPIKE_FILTER	ADC_MED_3	//Load-dump/cranking spike rejection on BAT and ALT
+#define ISOLATOR_PULLIN_TIME	200		//ms full coil drive, 0-economizer off
+#define ISOLATOR_HOLD_DUTY		OUT_DUTY_PCT(40)	//Coil hold PWM, open-drain isolator only
+//#define ISOLATOR_COMPARATOR	CMP_REF_BANDGAP	//Short detector, needs isolator monitor tap on AIN1 (PD7)
 
 #define ALTERNATOR_ACT_VOLTAGE	10000
+#define ALTERNATOR_ACT_LEVEL	ADC_MV_TO_FILT(ALTERNATOR_ACT_VOLTAGE)	//Filtered ALT, Q10.6
+#define ALTERNATOR_FILTER		2	//EMA shift for ALT ripple, alpha=1/2^N
 
+//All timeouts in ms, one main loop pass per system tick
 #define LOCKOUT_TIMEOUT			5000
 #define LOCKOUT_LED_TIMEOUT		30000
 
 #define KILL_DELAY_EXTERNAL		100
 #define KILL_DELAY_MASTER		100
 
-#define MASTER_DEBOUNCE			10
-#define KILL_DEBOUNCE			10
+#define MASTER_ASSERT			20	//Slow turn-on, no startup from a knock
+#define MASTER_RELEASE			5	//Fast turn-off
+#define KILL_ASSERT				2	//Fast kill
+#define KILL_RELEASE			50	//Conservative release, integrating
+#define WAKE_DEBOUNCE			(MASTER_ASSERT+2)	//ticks awake after power-down wake-up
+
+#define MASTER_STROBE			1	//Pull-up on for one sample every N ticks, 0-always on
+#define KILL_STROBE				0	//Not used with kill capture, needs continuous pull-up
+#define KILL_CAPTURE			1	//Pin change capture, kill latched without debounce
+#define INPUT_SETTLE_US			40	//Switch wiring RC settle time after pull-up on
+//#define INPUT_CHARACTERIZE		//Measure switch bounce, tuned limits stored to EEPROM before power-down
+//#define INPUT_AUTO_TUNE			//Master release and kill assert limits from EEPROM, measured bounce
 
 #define IGNC_FAULT_CNT_LIMIT	5
 
+//Task periods and phases in ticks (ms)
+#define TASK_LED_PERIOD			10
+#define TASK_LED_PHASE			3
+#define TASK_WDT_PERIOD			100
+#define TASK_WDT_PHASE			7
+
+#define LED_MS(ms)	((ms)/TASK_LED_PERIOD)
+
+//Benchmark, typical MCU currents @5V per 1MHz of CPU clock, tune from bench measurements
+#define BENCH_WINDOW			1000	//ticks per state between updates
+#define BENCH_ACTIVE_UA			550
+#define BENCH_IDLE_UA			120
+#define BENCH_BASE_UA			250		//ADC, BOD, dividers, independent of sleep
+#define BENCH_STATE_COUNT		5
+
 /**** Private variables ****/
 static volatile uint8_t sys_state;
 
 static volatile uint8_t master_act = 0;
 static volatile uint8_t kill_act = 0;
 
-static volatile uint16_t u_bat = 12000;
+//Calibrated ADC counts, filtered ALT in Q10.6
+static volatile uint16_t u_bat = ADC_MV_TO_COUNTS(12000);
 static volatile uint16_t u_alt = 0;
 static volatile uint16_t u_isol = 0;
 static volatile uint16_t u_ignc = 0;
-static volatile uint16_t u_relay_drop = 0;
+static volatile uint16_t u_relay_pair = 0; //Paired BAT/ALT samples, calibrated counts
+static volatile uint16_t u_alt_filt = 0;
+
+static volatile uint8_t fast_scan = 0;
+static volatile uint8_t precise_timer = 0;
+static volatile uint8_t slow_timer = 0;
+static volatile uint8_t c_bat = 0;
+static volatile uint8_t c_alt = 0;
+static volatile uint8_t c_isol = 0;
+static volatile uint8_t c_ignc = 0;
+static volatile uint8_t c_relay_drop = 0;
+static volatile uint8_t out_fresh = 0; //Outputs sampled in last scan, OUT_FRESH bits
+static volatile uint8_t scan_pending = 0; //Scan started by StartDataGathering, not read yet
 
 static volatile uint8_t isolator_act = 0;
 static volatile uint8_t isolator_act_change = 0;
-static volatile uint8_t ignition_act = 0;
-static volatile uint8_t alternator_act = 0;
 
 static volatile uint8_t relay_ocp_en = 0;
 static volatile uint8_t relay_ocp_deadtime = 0;
+static i2tDef relay_i2t;
+static slopeDef relay_slope;
+
+static volatile uint16_t kill_latency = 0; //Kill edge to KILLING state, 8us units
+
+#ifdef BENCHMARK
+//Results per system state, watch in debugger
+static volatile uint16_t bench_load[BENCH_STATE_COUNT]; //CPU busy, 0.1%
+static volatile uint16_t bench_current[BENCH_STATE_COUNT]; //Estimated supply current, uA
+static uint16_t bench_ticks[BENCH_STATE_COUNT];
+static uint32_t bench_busy[BENCH_STATE_COUNT];
+#endif
 
 /**** Private function declarations ****/
 void Init_watchdog(void);
@@ -83,10 +187,32 @@ void Init_ReducePower(void);
 
 void DelaySystem(uint16_t cycles);
 void DataGathering(uint16_t cycles);
+void ReadInputs(void);
+void StartDataGathering(void);
 uint8_t Startup_Procedure(void);
 uint8_t Kill_Procedure(void);
 uint8_t Lockout_Procedure(void);
-uint8_t IsolatorOCP(void);
+uint8_t Sleep_Procedure(void);
+void PowerDown(void);
+uint8_t IsolatorOCP(uint16_t relay_drop);
+
+void Task_Protection(void);
+void Task_Control(void);
+void Task_Led(void);
+void Task_Watchdog(void);
+void Benchmark_Update(uint8_t state, uint8_t busy);
+
+/**** Task table ****/
+//Run in table order, protection first. Overruns of task 0 show missed OCP ticks.
+static const schTaskDef tasks[] = {
+	{Task_Protection,	1,					0},
+	{Task_Control,		1,					0},
+	{Task_Led,			TASK_LED_PERIOD,	TASK_LED_PHASE},
+	#ifdef WDT_ENABLED
+	{Task_Watchdog,		TASK_WDT_PERIOD,	TASK_WDT_PHASE},
+	#endif
+};
+#define TASK_COUNT	(sizeof(tasks)/sizeof(tasks[0]))
 
 /**** Application ****/
 int main(void)
@@ -97,12 +223,27 @@ int main(void)
 	Init_watchdog();
 	#endif
 	Init_ReducePower();
+	CLKDRV_Init();
 	
 	BSDRV_Init();
 	LEDDRV_Init();
 	ADCDRV_Init(1); //start ADC in waked state
+	//Reject single sample spikes on BAT and ALT
+	ADCDRV_SetMedian(ADC_BATU,ISOLATOR_SPIKE_FILTER);
+	ADCDRV_SetMedian(ADC_ALTU,ISOLATOR_SPIKE_FILTER);
+	//Smooth alternator ripple for rundown detection, protection uses raw values
+	ADCDRV_SetFilter(ADC_ALTU,ADC_FILT_EMA,ALTERNATOR_FILTER);
+	I2TDRV_Init(&relay_i2t,I2T_MV_TO_DROP(ISOLATOR_DROP_LIMIT),ISOLATOR_DROP_TAU);
+	SLPDRV_Init(&relay_slope,I2T_MV_TO_DROP(ISOLATOR_DROP_HARD),SLP_MV_TO_SLOPE(ISOLATOR_DROP_SLOPE),ISOLATOR_DROP_HORIZON);
 	LEDDRV_OnSolid();
 	LEDDRV_Process();
+	TICKDRV_Init();
+	
+	//ADC scan and system tick are interrupt driven
+	sei();
+	#ifdef ADC_FREE_RUNNING
+	ADCDRV_StartFreeRun();
+	#endif
 
 	//Wait for system inputs to stabilize
 	DelaySystem(10);
@@ -114,50 +255,87 @@ int main(void)
 	else relay_ocp_en = 1;
 	
 	//***Inputs setup
-	inCfgDef mstrSwCfg;
-	inCfgDef killSwCfg;
+	inCfgDef inCfg[IN_COUNT];
+	inCfgDef* pMstrSwCfg = &inCfg[IN_MASTER-1];
+	inCfgDef* pKillSwCfg = &inCfg[IN_KILL-1];
 	
-	mstrSwCfg.act_level = IN_ACT_LOW;
-	mstrSwCfg.pull = IN_PULL_UP;
-	mstrSwCfg.dbnc_limit = MASTER_DEBOUNCE;
+	pMstrSwCfg->act_level = IN_ACT_LOW;
+	pMstrSwCfg->pull = IN_PULL_UP;
+	pMstrSwCfg->assert_limit = MASTER_ASSERT;
+	pMstrSwCfg->release_limit = MASTER_RELEASE;
+	pMstrSwCfg->dbnc_mode = IN_DBNC_RESET;
+	pMstrSwCfg->strobe = MASTER_STROBE;
+	pMstrSwCfg->settle = INPUT_SETTLE_US;
+	pMstrSwCfg->capture = 0;
 	 
-	//if(BSDRV_GetBootstrap(3)) mstrSwCfg.dbnc_limit = 100; //High filtering, long debounce time
-	//else mstrSwCfg.dbnc_limit = 10; //Normal filtering, short debounce time
+	//if(BSDRV_GetBootstrap(3)) pMstrSwCfg->assert_limit = 100; //High filtering, long debounce time
+	//else pMstrSwCfg->assert_limit = 10; //Normal filtering, short debounce time
 	
-	if(BSDRV_GetBootstrap(2)) killSwCfg.act_level = IN_ACT_HIGH; //Normally closed kill button
-	else killSwCfg.act_level = IN_ACT_LOW; //Normally open kill button
-	killSwCfg.pull = IN_PULL_UP;
-	killSwCfg.dbnc_limit = KILL_DEBOUNCE;
+	if(BSDRV_GetBootstrap(2)) pKillSwCfg->act_level = IN_ACT_HIGH; //Normally closed kill button
+	else pKillSwCfg->act_level = IN_ACT_LOW; //Normally open kill button
+	pKillSwCfg->pull = IN_PULL_UP;
+	pKillSwCfg->assert_limit = KILL_ASSERT;
+	pKillSwCfg->release_limit = KILL_RELEASE;
+	pKillSwCfg->dbnc_mode = IN_DBNC_INTEGRATE;
+	pKillSwCfg->strobe = KILL_STROBE;
+	pKillSwCfg->settle = INPUT_SETTLE_US;
+	pKillSwCfg->capture = KILL_CAPTURE;
 	
-	//if(BSDRV_GetBootstrap(3)) killSwCfg.dbnc_limit = 100; //High filtering, long debounce time
-	//else killSwCfg.dbnc_limit = 10; //Normal filtering, short debounce time
+	//if(BSDRV_GetBootstrap(3)) pKillSwCfg->assert_limit = 100; //High filtering, long debounce time
+	//else pKillSwCfg->assert_limit = 10; //Normal filtering, short debounce time
 	
-	INDRV_Init(&mstrSwCfg,&killSwCfg);
+	#ifdef INPUT_AUTO_TUNE
+	//Only bounce filtering limits, master assert and kill release are policy
+	uint8_t tuned = INDRV_GetStoredLimit(IN_MASTER);
+	if(tuned!=IN_LIMIT_NONE) pMstrSwCfg->release_limit = tuned;
+	tuned = INDRV_GetStoredLimit(IN_KILL);
+	if(tuned!=IN_LIMIT_NONE) pKillSwCfg->assert_limit = tuned;
+	#endif
+	
+	INDRV_Init(inCfg);
 	
 	INDRV_Wake(IN_MASTER);
 	INDRV_Wake(IN_KILL);
+	
+	#ifdef INPUT_CHARACTERIZE
+	INDRV_SetCharacterize(IN_MASTER,1);
+	INDRV_SetCharacterize(IN_KILL,1);
+	#endif
 
 	//***Outputs setup
-	outConfigDef isolCfg;
-	outConfigDef igncCfg;
-	
-	if(BSDRV_GetBootstrap(0)) isolCfg.type = OUT_TYPE_OD; //Active low
-	else isolCfg.type = OUT_TYPE_OS; //Active high
-	//if(BSDRV_GetBootstrap(0) igncCfg.inv = 1; //Active low
-	//else igncCfg.inv = 0; //Active high
-	//isolCfg.type = OUT_TYPE_PP;
-	isolCfg.inv = 0;
-	isolCfg.ext_fault_en = 1;
-	
-	if(BSDRV_GetBootstrap(1)) igncCfg.type = OUT_TYPE_OD; //Active low
-	else igncCfg.type = OUT_TYPE_OS; //Active high
-	//if(BSDRV_GetBootstrap(1) igncCfg.inv = 1; //Active low
-	//else igncCfg.inv = 0; //Active high
-	//igncCfg.type = OUT_TYPE_PP;
-	igncCfg.inv = 0;
-	igncCfg.ext_fault_en = 0;
-	
-	OUTDRV_Init(&isolCfg,&igncCfg);
+	outConfigDef outCfg[OUT_COUNT];
+	outConfigDef* pIsolCfg = &outCfg[OUT_ISOL-1];
+	outConfigDef* pIgncCfg = &outCfg[OUT_IGNC-1];
+	
+	if(BSDRV_GetBootstrap(0)) pIsolCfg->type = OUT_TYPE_OD; //Active low
+	else pIsolCfg->type = OUT_TYPE_OS; //Active high
+	//if(BSDRV_GetBootstrap(0) pIgncCfg->inv = 1; //Active low
+	//else pIgncCfg->inv = 0; //Active high
+	//pIsolCfg->type = OUT_TYPE_PP;
+	pIsolCfg->inv = 0;
+	pIsolCfg->ext_fault_en = 1;
+	pIsolCfg->pullin_time = ISOLATOR_PULLIN_TIME;
+	pIsolCfg->hold_duty = ISOLATOR_HOLD_DUTY;
+	
+	if(BSDRV_GetBootstrap(1)) pIgncCfg->type = OUT_TYPE_OD; //Active low
+	else pIgncCfg->type = OUT_TYPE_OS; //Active high
+	//if(BSDRV_GetBootstrap(1) pIgncCfg->inv = 1; //Active low
+	//else pIgncCfg->inv = 0; //Active high
+	//pIgncCfg->type = OUT_TYPE_PP;
+	pIgncCfg->inv = 0;
+	pIgncCfg->ext_fault_en = 0;
+	pIgncCfg->pullin_time = 0;
+	pIgncCfg->hold_duty = 0;
+	pIgncCfg->comp_trip = 0;
+	
+	#ifdef ISOLATOR_COMPARATOR
+	CMPDRV_Init(ISOLATOR_COMPARATOR);
+	pIsolCfg->comp_trip = 1;
+	#else
+	pIsolCfg->comp_trip = 0;
+	#endif
+	
+	OUTDRV_Init(outCfg);
 	
 	//Set initial target values
 	OUTDRV_DisableOutput(OUT_ISOL);
@@ -177,88 +355,160 @@ int main(void)
 	INDRV_Sleep(IN_KILL);
 	LEDDRV_Off();
 
+	//Start scheduling, first tasks run on next tick
+	SCHDRV_Init(tasks,TASK_COUNT);
+	
 	//main loop
 	while(1)
 	{
-		/******* Input data gathering ***********************************/
-		//One system tick is 13.5*4*(1/adc_clock) = 0.864ms
-		DataGathering(1);
-		
-		/******* Output protection processing ***************************/
-		OUTDRV_ProcessProtection(u_bat,u_isol,u_alt,u_ignc);
-		
-		if(isolator_act_change)
-		{ 
-			//Insert OCP dead time, after output state change
-			relay_ocp_deadtime = ISOLATOR_OCP_DEADTIME;
-			isolator_act_change = 0;
-		};
-		
-		if(OUTDRV_GetFault(OUT_ISOL)&&(sys_state==ACTIVE))
-		{
-			//If isolator control OCP, then turn off IGNC and go to killed state
-			OUTDRV_DelayFaultExecution(OUT_ISOL,2);
-			sys_state = KILLING;
-			kill_act = 1;
-		};
-		
-		if(IsolatorOCP()&&(relay_ocp_en)&&(sys_state==ACTIVE))
-		{
-			//Do kill, force kill-switch active, for fast kill
-			sys_state = KILLING;
-			kill_act = 1;
-		};
-		
-		if((OUTDRV_GetFaultCount(OUT_IGNC)>IGNC_FAULT_CNT_LIMIT)&&(sys_state==ACTIVE))
-		{
-			//Do kill, force kill-switch active, for fast kill
-			sys_state = KILLING;
-			kill_act = 1;
-		};
-		
-		/******* State machine ******************************************/
-		switch(sys_state)
-		{
-			case SLEEP:
-				if(master_act) sys_state = STARTUP;
-				else sys_state = SLEEP;
-				break;
-				
-			case STARTUP:
-				sys_state = Startup_Procedure();
-				break;
-				
-			case ACTIVE:
-				if((!master_act)||(kill_act)) sys_state = KILLING;
-				else sys_state = ACTIVE;
-				break;
-				
-			case KILLING:
-				sys_state = Kill_Procedure();
-				break;
-				
-			case LOCKOUT:
-				sys_state = Lockout_Procedure();
-				break;
-				
-			default:
-				sys_state = KILLING;
-				break;
-		}
-		
-		/******* Output HW processing ***********************************/
-		OUTDRV_ProcessLogic();
-		
-		/******* LED Control processing *********************************/
-		LEDDRV_Process();
-		
-		/******* Wathcdog keep alive  ***********************************/
-		#ifdef WDT_ENABLED
-		wdt_reset();
+		//One pass per 1ms Timer0 tick, independent of ADC timing
+		//CPU sleeps in Idle mode when tasks of the tick are done
+		uint8_t ticks = TICKDRV_WaitTick();
+		#ifdef BENCHMARK
+		Benchmark_Update(sys_state,TICKDRV_GetBusy());
 		#endif
+		SCHDRV_Run(ticks);
 	}
 }
 
+/**** Tasks ****/
+/**
+ * @brief Input data gathering and protection, every tick
+ */
+void Task_Protection(void)
+{
+	/******* Input data gathering ***********************************/
+	//Scan was started after output logic of previous tick, converted while CPU waits for tick.
+	//At slow clock scan is started every few ticks and read when complete, outputs are off
+	if((CLKDRV_GetSpeed()==CLOCK_FAST)||((scan_pending)&&(ADCDRV_GetScanComplete()))) DataGathering(1);
+	else
+	{
+		out_fresh = 0;
+		ReadInputs();
+	};
+	
+	/******* Output protection processing ***************************/
+	if(fast_scan) OUTDRV_ProcessFastProtection(c_bat,c_isol,c_alt,c_ignc,out_fresh);
+	else OUTDRV_ProcessProtection(u_bat,u_isol,u_alt,u_ignc,out_fresh);
+	
+	if(isolator_act_change)
+	{ 
+		//Insert OCP dead time, after output state change
+		relay_ocp_deadtime = ISOLATOR_OCP_DEADTIME;
+		isolator_act_change = 0;
+	};
+	
+	if(OUTDRV_GetFault(OUT_ISOL)&&(sys_state==ACTIVE))
+	{
+		//If isolator control OCP, then turn off IGNC and go to killed state
+		OUTDRV_DelayFaultExecution(OUT_ISOL,2);
+		sys_state = KILLING;
+		kill_act = 1;
+	};
+	
+	//I2t and slope from same unfiltered drop on every scan, filter lag would hide the rise
+	uint8_t relay_ocp = 0;
+	if(fast_scan) relay_ocp = IsolatorOCP(I2T_FROM_FAST(c_relay_drop));
+	else relay_ocp = IsolatorOCP(I2T_FROM_COUNTS(u_relay_pair));
+	
+	if((relay_ocp)&&(relay_ocp_en)&&(sys_state==ACTIVE))
+	{
+		//Do kill, force kill-switch active, for fast kill
+		sys_state = KILLING;
+		kill_act = 1;
+	};
+	
+	if((OUTDRV_GetFaultCount(OUT_IGNC)>IGNC_FAULT_CNT_LIMIT)&&(sys_state==ACTIVE))
+	{
+		//Do kill, force kill-switch active, for fast kill
+		sys_state = KILLING;
+		kill_act = 1;
+	};
+}
+
+/**
+ * @brief System state machine and output HW processing
+ */
+void Task_Control(void)
+{
+	/******* State machine ******************************************/
+	switch(sys_state)
+	{
+		case SLEEP:
+			sys_state = Sleep_Procedure();
+			break;
+			
+		case STARTUP:
+			sys_state = Startup_Procedure();
+			break;
+			
+		case ACTIVE:
+			if((!master_act)||(kill_act))
+			{
+				//Captured kill edge is latched by ISR, measure edge to kill latency
+				uint16_t stamp = 0;
+				if(INDRV_GetCapture(IN_KILL,&stamp)) kill_latency = TICKDRV_GetStamp()-stamp;
+				sys_state = KILLING;
+			}
+			else sys_state = ACTIVE;
+			break;
+			
+		case KILLING:
+			sys_state = Kill_Procedure();
+			break;
+			
+		case LOCKOUT:
+			sys_state = Lockout_Procedure();
+			break;
+			
+		default:
+			sys_state = KILLING;
+			break;
+	}
+	
+	/******* Output HW processing ***********************************/
+	OUTDRV_ProcessLogic();
+	
+	/******* Clock policy *******************************************/
+	//Full speed where protection latency matters, low clock when idle.
+	//Clock driver stops conversions for the change, ADC driver keeps free-running
+	//off while conversion is shorter than its ISR, next scan is precise at low clock
+	if((sys_state==LOCKOUT)||(sys_state==SLEEP)) CLKDRV_SetSpeed(CLOCK_SLOW);
+	else CLKDRV_SetSpeed(CLOCK_FAST);
+	
+	/******* Next scan **********************************************/
+	//After output logic, so protection never sees samples from before a level change
+	if(CLKDRV_GetSpeed()==CLOCK_FAST)
+	{
+		slow_timer = 0;
+		StartDataGathering();
+	}
+	else if(slow_timer) slow_timer--;
+	else
+	{
+		slow_timer = ADC_SLOW_PERIOD-1;
+		StartDataGathering();
+	};
+}
+
+/**
+ * @brief LED control processing
+ */
+void Task_Led(void)
+{
+	LEDDRV_Process();
+}
+
+#ifdef WDT_ENABLED
+/**
+ * @brief Watchdog keep alive
+ */
+void Task_Watchdog(void)
+{
+	wdt_reset();
+}
+#endif
+
 /**** Private function definitions ****/
 /**
  * @brief Delay system by pointlessly measuring ADC channels
@@ -280,39 +530,159 @@ void DataGathering(uint16_t cycles)
 {
 	for(uint16_t i=0; i<cycles; i++)
 	{
-		ADCDRV_MeasureAll();
-		u_bat = ADCDRV_GetValue(ADC_BATU);
-		u_alt = ADCDRV_GetValue(ADC_ALTU);
-		u_isol = ADCDRV_GetValue(ADC_ISOL);
-		u_ignc = ADCDRV_GetValue(ADC_IGNC);
-		
-		INDRV_ReadAll();
-		master_act = INDRV_GetInput(IN_MASTER);
-		kill_act = INDRV_GetInput(IN_KILL);
-		
-		uint8_t i  = OUTDRV_GetRealOutput(OUT_ISOL);
-		if(isolator_act!=i) isolator_act_change = 1;
-		isolator_act = i;
-		ignition_act = OUTDRV_GetRealOutput(OUT_IGNC);
+		//Wait for scan started after output logic (or next free-running buffer),
+		//passes outside of task loop start their own
+		if(!scan_pending) StartDataGathering();
+		while(!ADCDRV_GetScanComplete()) ADCDRV_WaitConversion();
+		scan_pending = 0;
 		
-		//Alternator activity detection
-		//uint16_t temp = 0;
-		//if(u_bat>100) temp = u_bat-100;
-		//else temp = u_bat;
+		//Output monitors are not in every frame, older values are repeats
+		out_fresh = 0;
+		if(ADCDRV_GetSampleAge(ADC_ISOL)<ADC_SCAN_FRAME) out_fresh |= OUT_FRESH(OUT_ISOL);
+		if(ADCDRV_GetSampleAge(ADC_IGNC)<ADC_SCAN_FRAME) out_fresh |= OUT_FRESH(OUT_IGNC);
 		
-		if(u_alt>u_bat)
+		if(fast_scan)
 		{
-			u_relay_drop = u_alt-u_bat;
-			alternator_act=1;
+			//Protection only values, 8bit
+			c_bat = ADCDRV_GetFastValue(ADC_BATU);
+			c_alt = ADCDRV_GetFastValue(ADC_ALTU);
+			c_isol = ADCDRV_GetFastValue(ADC_ISOL);
+			c_ignc = ADCDRV_GetFastValue(ADC_IGNC);
+			
+			//Paired BAT/ALT samples, no skew between channels
+			c_relay_drop = ADCDRV_GetFastRelayDrop();
 		}
-		else 
+		else
 		{
-			u_relay_drop = u_bat-u_alt;
-			alternator_act=0;
+			//Calibrated counts, limits are converted at compile time
+			u_bat = ADCDRV_GetCounts(ADC_BATU);
+			u_alt = ADCDRV_GetCounts(ADC_ALTU);
+			u_isol = ADCDRV_GetCounts(ADC_ISOL);
+			u_ignc = ADCDRV_GetCounts(ADC_IGNC);
+			u_alt_filt = ADCDRV_GetFilteredCounts(ADC_ALTU);
+			
+			//Paired BAT/ALT samples, same as fast scans
+			u_relay_pair = ADCDRV_GetRelayDropCounts();
 		}
+		
+		ReadInputs();
 	}
 }
 
+/**
+ * @brief Read switch inputs and real output states
+ */
+void ReadInputs(void)
+{
+	INDRV_ReadAll();
+	master_act = INDRV_GetInput(IN_MASTER);
+	kill_act = INDRV_GetInput(IN_KILL);
+	
+	uint8_t i  = OUTDRV_GetRealOutput(OUT_ISOL);
+	if(isolator_act!=i) isolator_act_change = 1;
+	isolator_act = i;
+}
+
+/**
+ * @brief Start next scan, read by next DataGathering pass
+ */
+void StartDataGathering(void)
+{
+	//Last scan isn't read yet, at slow clock it may span ticks
+	if(scan_pending) return;
+	
+	#ifdef ADC_FAST_PROTECTION
+	//Interleave fast 8bit protection scans with precise 10bit scans,
+	//outputs are off at slow clock, there every scan is precise
+	if(CLKDRV_GetSpeed()!=CLOCK_FAST){precise_timer = 0; fast_scan = 0;}
+	else if(precise_timer){precise_timer--; fast_scan = 1;}
+	else{precise_timer = ADC_PRECISE_PERIOD-1; fast_scan = 0;}
+	
+	if(fast_scan) ADCDRV_SetResolution(ADC_RES_8BIT);
+	else ADCDRV_SetResolution(ADC_RES_10BIT);
+	#endif
+	
+	ADCDRV_StartScan();
+	scan_pending = 1;
+}
+
+/**
+ * @brief System sleep procedure, power-down until master switch changes
+ * @return Next system state
+ */
+uint8_t Sleep_Procedure(void)
+{
+	#ifdef SLEEP_POWER_DOWN
+	static uint8_t wake_timer = 0;
+	#endif
+	
+	if(master_act) return STARTUP;
+	
+	#ifdef SLEEP_POWER_DOWN
+	//Pin change is not debounced, stay awake while tick paced debounce runs
+	if(wake_timer)
+	{
+		wake_timer--;
+		return SLEEP;
+	};
+	
+	#ifdef INPUT_CHARACTERIZE
+	INDRV_StoreTunedLimits();
+	#endif
+	
+	PowerDown();
+	wake_timer = WAKE_DEBOUNCE;
+	#endif
+	
+	return SLEEP;
+}
+
+/**
+ * @brief Power down ADC and MCU, wake-up by master switch pin change
+ */
+void PowerDown(void)
+{
+	//Stop conversions and remove ADC power
+	ADCDRV_Sleep();
+	#ifdef ISOLATOR_COMPARATOR
+	CMPDRV_Sleep(); //Outputs are HiZ, comparator is not armed
+	#endif
+	#ifdef WDT_ENABLED
+	wdt_disable();
+	#endif
+	
+	//Not armed if master switch is already changing
+	uint8_t armed = INDRV_ArmWakeup(IN_MASTER);
+	
+	cli();
+	//Pin may have changed after wake-up was armed, ISR disarms it
+	if((armed)&&(INDRV_GetWakeupArmed()))
+	{
+		SMCR = 0x05; //Power-down mode, sleep enable
+		sleep_bod_disable(); //BOD off during sleep, timed sequence
+		sei();
+		sleep_cpu(); //sei() guarantees one instruction before any interrupt
+		SMCR = 0x00; //Sleep disable
+	};
+	sei();
+	
+	INDRV_DisarmWakeup();
+	#ifdef WDT_ENABLED
+	wdt_reset();
+	Init_watchdog();
+	#endif
+	
+	#ifdef ISOLATOR_COMPARATOR
+	CMPDRV_Wake();
+	#endif
+	
+	//Restore ADC, first free-running buffer is fresh
+	ADCDRV_Wake();
+	#ifdef ADC_FREE_RUNNING
+	ADCDRV_StartFreeRun();
+	#endif
+}
+
 /**
  * @brief System startup (wake-up) procedure
  * @return Next system state
@@ -324,7 +694,7 @@ uint8_t Startup_Procedure(void)
 	
 	if(step==0)
 	{	
-		//Wake up inputs, give N ticks for wakeup
+		//Wake up inputs, give N ms for wakeup
 		INDRV_Wake(IN_KILL);
 		LEDDRV_OnSolid();
 		timeout = 100;
@@ -340,7 +710,7 @@ uint8_t Startup_Procedure(void)
 	{
 		if((!master_act)||(kill_act)){step = 0;return LOCKOUT;};
 		
-		//Turn on isolator, and give N ticks to catch errors
+		//Turn on isolator, and give N ms to catch errors
 		OUTDRV_EnableOutput(OUT_ISOL);
 		OUTDRV_SetOutput(OUT_ISOL);
 		timeout = 200;
@@ -361,7 +731,7 @@ uint8_t Startup_Procedure(void)
 		if(timeout) timeout--;
 		else
 		{
-			//Turn on ignition, and give N ticks to catch errors
+			//Turn on ignition, and give N ms to catch errors
 			OUTDRV_EnableOutput(OUT_IGNC);
 			OUTDRV_SetOutput(OUT_IGNC);
 			timeout = 200;
@@ -401,7 +771,7 @@ uint8_t Kill_Procedure(void)
 	if(step==0)
 	{
 		//Turn off ignition
-		LEDDRV_Flashing(200);
+		LEDDRV_Flashing(LED_MS(200));
 		OUTDRV_ResetOutput(OUT_IGNC);
 		if(kill_act) timeout = KILL_DELAY_EXTERNAL;
 		else timeout = KILL_DELAY_MASTER;
@@ -409,8 +779,8 @@ uint8_t Kill_Procedure(void)
 	}
 	else if(step==1)
 	{
-		//Wait for alternator rundown
-		if(u_alt<ALTERNATOR_ACT_VOLTAGE) step=2;
+		//Wait for alternator rundown, ripple filtered
+		if(u_alt_filt<ALTERNATOR_ACT_LEVEL) step=2;
 		
 		//If kill activated, then reduce timeout
 		if((timeout>KILL_DELAY_EXTERNAL)&&(kill_act)) timeout=KILL_DELAY_EXTERNAL;
@@ -461,7 +831,7 @@ uint8_t Lockout_Procedure(void)
 		OUTDRV_DisableOutput(OUT_IGNC);
 		//Set KILL to sleep
 		INDRV_Sleep(IN_KILL);
-		LEDDRV_Flashing(1000);
+		LEDDRV_Flashing(LED_MS(1000));
 		led_timeout = LOCKOUT_LED_TIMEOUT;
 		timeout=LOCKOUT_TIMEOUT;
 		step=1;
@@ -491,6 +861,33 @@ uint8_t Lockout_Procedure(void)
 	return LOCKOUT;
 }
 
+#ifdef BENCHMARK
+/**
+ * @brief Accumulate busy time of tick, update per-state load and current
+ * @param [in] state System state the tick was spent in
+ * @param [in] busy Busy time of tick, 8us units
+ */
+void Benchmark_Update(uint8_t state, uint8_t busy)
+{
+	if(state>=BENCH_STATE_COUNT) return;
+	
+	bench_busy[state] += busy;
+	bench_ticks[state]++;
+	if(bench_ticks[state]<BENCH_WINDOW) return;
+	
+	//Busy sum of window to 0.1%
+	uint16_t load = (uint16_t)(bench_busy[state]/((uint32_t)BENCH_WINDOW*TICK_BUSY_FULL/1000));
+	if(load>1000) load = 1000;
+	bench_load[state] = load;
+	//Core current scales with CPU clock
+	uint32_t core = BENCH_IDLE_UA+(((uint32_t)(BENCH_ACTIVE_UA-BENCH_IDLE_UA)*load)/1000);
+	bench_current[state] = BENCH_BASE_UA+(uint16_t)((core*CLKDRV_GetFrequency())/1000);
+	
+	bench_busy[state] = 0;
+	bench_ticks[state] = 0;
+}
+#endif
+
 /**
  * @brief Initializes system watchdog
  */
@@ -508,52 +905,38 @@ void Init_watchdog(void)
 void Init_ReducePower(void)
 {
 	//Disable unnecessary peripherals
-	PRR = 0xAC;  //TWI,SPI,TIM0 and TIM1
+	PRR = 0xAC;  //TWI,SPI,TIM0 and TIM1, TIM0 is powered by system tick init, TIM1 by relay economizer hold
+	ACSR = 0x80; //Analog comparator, powered by comparator driver
 }
 
 /**
  * @brief Isolator relay over-current protection logic
+ * @param [in] relay_drop Unfiltered relay voltage drop, I2t drop units
  * @return Isolator fault status
  */
-uint8_t IsolatorOCP(void)
+uint8_t IsolatorOCP(uint16_t relay_drop)
 {		
 	uint16_t drop = 0;
-	uint8_t ocp_warning = 0;
 	static uint8_t ocp_fault = 0;
-	static uint8_t ocp_counter = 0;
 	static uint16_t cooldown_timer = 0;
 
 	//Adjust relay drop
-	if(isolator_act) drop = u_relay_drop;
+	if(isolator_act) drop = relay_drop;
 	else drop=0;
 	
-	//Check Over-Current warning
-	if((drop>ISOLATOR_DROP_LIMIT)&&(ISOLATOR_DROP_LIMIT!=0)) ocp_warning = 1;
-	else ocp_warning = 0;
-	
 	//Do delay calculations	
 	if(relay_ocp_deadtime) relay_ocp_deadtime--;
-	//OCP Delay
-	if((ocp_warning)&&(!relay_ocp_deadtime))
-	{
-		//Calculate increment
-		uint16_t x = drop/ISOLATOR_DROP_LIMIT;
-		if(x>255) x = 255;
-		uint8_t inc = (uint8_t)x;
-		
-		//Saturated add
-		uint8_t dtop = 255-ocp_counter;
-		if(inc>dtop) ocp_counter = 255;
-		else ocp_counter += inc;
-	}
-	else
-	{
-		//Saturated subtraction
-		if(ocp_counter) ocp_counter--;
-	}
+	//OCP I2t, only cooling in dead time
+	if(relay_ocp_deadtime) drop = 0;
+	uint8_t ocp_trip = I2TDRV_Update(&relay_i2t,drop);
+	
+	//Predictive trip, restart while relay is off or switching
+	uint8_t slope_trip = 0;
+	if((!isolator_act)||(relay_ocp_deadtime)) SLPDRV_Reset(&relay_slope,relay_drop);
+	else slope_trip = SLPDRV_Update(&relay_slope,relay_drop);
 	
 	//Check fault
-	if(ocp_counter>ISOLATOR_DROP_DELAY)
+	if((ocp_trip)||(slope_trip))
 	{
 		ocp_fault = 1;
 		if(!cooldown_timer)